@@ -1,574 +1,6306 @@
-
-
-#include <stdio.h>
-#include <stdlib.h> // For malloc, free, realloc, rand, srand, qsort
-#include <math.h>   // For exp, sqrt, pow (for Poisson and Std Dev)
-#include <time.h>   // For srand(time(NULL))
-#include <string.h> // For memset (used for mode calculation)
-
-// --- Simulation Constants ---
-#define SIMULATION_MINUTES 480 // 8 hours * 60 minutes
-#define MIN_SERVICE_TIME 2     // Minimum minutes to serve a customer
-#define MAX_SERVICE_TIME 3     // Maximum minutes to serve a customer
-#define INITIAL_STORAGE_CAPACITY 100 // Initial size for our dynamic wait-time array
-
-/*
- * ============================================================================
- * 1. STRUCT DEFINITIONS
- * ============================================================================
- */
-
-/**
- * @brief A single customer in the queue. This is a node in our linked list.
- */
-typedef struct Customer
-{
-    int arrival_minute;     // The minute the customer entered the queue
-    struct Customer *next;  // Pointer to the next customer in line
-} Customer;
-
-/**
- * @brief The queue manager. Holds pointers to the front and rear of the
- * linked list, allowing for O(1) enqueue and dequeue operations.
- */
-typedef struct Queue
-{
-    Customer *front; // Pointer to the head of the list
-    Customer *rear;  // Pointer to the tail of the list
-    int customer_count;
-} Queue;
-
-/**
- * @brief Represents a single bank teller.
- */
-typedef struct Teller
-{
-    int is_busy;                // 0 = free, 1 = busy
-    int remaining_service_time; // Minutes left until this teller is free
-} Teller;
-
-/**
- * @brief A dynamic array to store the wait times of all *served* customers.
- * This will grow as needed using realloc().
- */
-typedef struct WaitTimeStorage
-{
-    int *wait_times; // Pointer to the dynamically allocated array of wait times
-    int count;       // Current number of wait times stored
-    int capacity;    // Current total capacity of the array
-} WaitTimeStorage;
-
-/*
- * ============================================================================
- * 2. QUEUE MANAGEMENT FUNCTIONS (Linked List Implementation)
- * ============================================================================
- */
-
-/**
- * @brief Creates and initializes a new, empty queue.
- * @return Pointer to the newly allocated Queue.
- */
-Queue *create_queue()
-{
-    // Allocate memory for the queue manager struct
-    Queue *q = (Queue *)malloc(sizeof(Queue));
-    if (q == NULL)
-    {
-        perror("Failed to allocate memory for queue");
-        exit(EXIT_FAILURE);
-    }
-    q->front = NULL;
-    q->rear = NULL;
-    q->customer_count = 0;
-    return q;
-}
-
-/**
- * @brief Checks if the queue is empty.
- * @return 1 (true) if empty, 0 (false) if not.
- */
-int is_empty(Queue *q)
-{
-    return (q->front == NULL);
-}
-
-/**
- * @brief Adds a new customer to the REAR of the queue.
- * @param q The queue to modify.
- * @param arrival_minute The simulation minute the customer arrived.
- */
-void enqueue(Queue *q, int arrival_minute)
-{
-    // 1. Allocate memory for the new customer (node)
-    Customer *new_customer = (Customer *)malloc(sizeof(Customer));
-    if (new_customer == NULL)
-    {
-        perror("Failed to allocate memory for new customer");
-        exit(EXIT_FAILURE);
-    }
-    new_customer->arrival_minute = arrival_minute;
-    new_customer->next = NULL;
-
-    // 2. Link the new customer to the end of the list
-    if (is_empty(q))
-    {
-        // If queue is empty, new customer is both front and rear
-        q->front = new_customer;
-        q->rear = new_customer;
-    }
-    else
-    {
-        // Otherwise, link the current rear to the new customer
-        q->rear->next = new_customer;
-        // And update the rear to be the new customer
-        q->rear = new_customer;
-    }
-    q->customer_count++;
-}
-
-/**
- * @brief Removes and returns the customer from the FRONT of the queue.
- * Returns NULL if the queue is empty.
- * @param q The queue to modify.
- * @return Pointer to the removed Customer (or NULL).
- */
-Customer *dequeue(Queue *q)
-{
-    // 1. Check if queue is empty
-    if (is_empty(q))
-    {
-        return NULL;
-    }
-
-    // 2. Get the customer at the front
-    Customer *served_customer = q->front;
-
-    // 3. Move the front pointer to the next customer
-    q->front = q->front->next;
-
-    // 4. If the queue is now empty, update the rear pointer as well
-    if (q->front == NULL)
-    {
-        q->rear = NULL;
-    }
-
-    q->customer_count--;
-    return served_customer; // The calling function is responsible for free()-ing this customer
-}
-
-/**
- * @brief Frees all remaining customers in the queue and the queue itself.
- */
-void free_queue(Queue *q)
-{
-    Customer *current = q->front;
-    while (current != NULL)
-    {
-        Customer *temp = current;
-        current = current->next;
-        free(temp);
-    }
-    free(q);
-}
-
-/*
- * ============================================================================
- * 3. DYNAMIC ARRAY (WaitTimeStorage) FUNCTIONS
- * ============================================================================
- */
-
-/**
- * @brief Creates and initializes a new, empty storage for wait times.
- * @return Pointer to the newly allocated WaitTimeStorage.
- */
-WaitTimeStorage *create_storage()
-{
-    WaitTimeStorage *storage = (WaitTimeStorage *)malloc(sizeof(WaitTimeStorage));
-    if (storage == NULL)
-    {
-        perror("Failed to allocate memory for storage");
-        exit(EXIT_FAILURE);
-    }
-
-    // Allocate the initial array to hold wait times
-    storage->wait_times = (int *)malloc(INITIAL_STORAGE_CAPACITY * sizeof(int));
-    if (storage->wait_times == NULL)
-    {
-        perror("Failed to allocate memory for initial wait time array");
-        exit(EXIT_FAILURE);
-    }
-
-    storage->count = 0;
-    storage->capacity = INITIAL_STORAGE_CAPACITY;
-    return storage;
-}
-
-/**
- * @brief Adds a new wait time to the storage, resizing the array if necessary.
- * This is the "dynamic" part of the array.
- * @param storage The storage to modify.
- * @param wait_time The new wait time to add.
- */
-void add_wait_time(WaitTimeStorage *storage, int wait_time)
-{
-    // 1. Check if the array is full
-    if (storage->count == storage->capacity)
-    {
-        // If full, double the capacity
-        int new_capacity = storage->capacity * 2;
-        int *new_array = (int *)realloc(storage->wait_times, new_capacity * sizeof(int));
-
-        if (new_array == NULL)
-        {
-            perror("Failed to re-allocate memory for wait time array");
-            // We can't add the new time, but the old data is still valid.
-            // In a real-world app, we'd handle this more gracefully.
-            return;
-        }
-
-        storage->wait_times = new_array;
-        storage->capacity = new_capacity;
-    }
-
-    // 2. Add the new wait time
-    storage->wait_times[storage->count] = wait_time;
-    storage->count++;
-}
-
-/**
- * @brief Frees the dynamic array and the storage struct itself.
- */
-void free_storage(WaitTimeStorage *storage)
-{
-    free(storage->wait_times);
-    free(storage);
-}
-
-/*
- * ============================================================================
- * 4. SIMULATION & MATH FUNCTIONS
- * ============================================================================
- */
-
-/**
- * @brief Generates a random number of customer arrivals for a given minute
- * using the Poisson distribution (Knuth's algorithm).
- * @param lambda The average number of arrivals per minute.
- * @return The (random) number of customers (k) who arrived this minute.
- */
-int get_poisson_random(double lambda)
-{
-    // This algorithm is a standard, efficient way to generate
-    // Poisson-distributed random numbers.
-    double L = exp(-lambda);
-    double p = 1.0;
-    int k = 0;
-
-    do
-    {
-        k++;
-        // Get a random float between 0.0 and 1.0
-        double u = (double)rand() / RAND_MAX;
-        p *= u;
-    } while (p > L);
-
-    return k - 1;
-}
-
-/**
- * @brief Gets a random service time for a customer.
- * @return A random integer between MIN_SERVICE_TIME and MAX_SERVICE_TIME.
- */
-int get_service_time()
-{
-    // (rand() % (MAX - MIN + 1)) + MIN
-    return (rand() % (MAX_SERVICE_TIME - MIN_SERVICE_TIME + 1)) + MIN_SERVICE_TIME;
-}
-
-/*
- * ============================================================================
- * 5. DATA ANALYSIS FUNCTIONS
- * ============================================================================
- */
-
-/**
- * @brief A comparison function required by qsort() to sort integers.
- */
-int compare_int(const void *a, const void *b)
-{
-    return (*(int *)a - *(int *)b);
-}
-
-/**
- * @brief Calculates the mean (average) of the wait times.
- */
-double get_mean(int *data, int n)
-{
-    if (n == 0) return 0.0;
-    long long sum = 0; // Use long long to prevent overflow
-    for (int i = 0; i < n; i++)
-    {
-        sum += data[i];
-    }
-    return (double)sum / n;
-}
-
-/**
- * @brief Calculates the median (middle value) of the wait times.
- * @note This function ASSUMES the data array has already been sorted.
- */
-double get_median(int *sorted_data, int n)
-{
-    if (n == 0) return 0.0;
-    
-    if (n % 2 == 0)
-    {
-        // Even number of elements: average the two middle ones
-        int mid1 = sorted_data[n / 2 - 1];
-        int mid2 = sorted_data[n / 2];
-        return (double)(mid1 + mid2) / 2.0;
-    }
-    else
-    {
-        // Odd number of elements: return the middle one
-        return (double)sorted_data[n / 2];
-    }
-}
-
-/**
- * @brief Calculates the mode (most frequent value) of the wait times.
- * Uses a frequency array for efficiency.
- */
-int get_mode(int *data, int n)
-{
-    if (n == 0) return 0;
-
-    // We need to find the max wait time to size our frequency array.
-    // (We could also just use the max possible sim time)
-    int max_val = 0;
-    for (int i = 0; i < n; i++) {
-        if (data[i] > max_val) max_val = data[i];
-    }
-
-    // What if the max wait time is 0 (e.g., no customers)?
-    // We still need an array of at least size 1.
-    int freq_array_size = (max_val < 1) ? 1 : max_val + 1;
-
-    // Allocate a frequency array and initialize to zero
-    // calloc is perfect for this, as it zeroes the memory.
-    int *frequency = (int *)calloc(freq_array_size, sizeof(int));
-    if (frequency == NULL) {
-        perror("Failed to allocate memory for mode calculation");
-        return -1; // Error
-    }
-
-    // Populate the frequency array
-    for (int i = 0; i < n; i++)
-    {
-        frequency[data[i]]++;
-    }
-
-    // Find the index (value) with the highest frequency
-    int mode = 0;
-    int max_freq = 0;
-    for (int i = 0; i < freq_array_size; i++)
-    {
-        if (frequency[i] > max_freq)
-        {
-            max_freq = frequency[i];
-            mode = i;
-        }
-    }
-
-    free(frequency); // Clean up the frequency array
-    return mode;
-}
-
-/**
- * @brief Calculates the standard deviation of the wait times.
- */
-double get_std_dev(int *data, int n, double mean)
-{
-    if (n == 0) return 0.0;
-    
-    double sum_sq_diff = 0.0;
-    for (int i = 0; i < n; i++)
-    {
-        sum_sq_diff += pow(data[i] - mean, 2);
-    }
-    return sqrt(sum_sq_diff / n);
-}
-
-/**
- * @brief Finds the single longest wait time.
- * @note This function ASSUMES the data array has already been sorted.
- */
-int get_max_wait(int *sorted_data, int n)
-{
-    if (n == 0) return 0;
-    return sorted_data[n - 1]; // The last element of the sorted array
-}
-
-/*
- * ============================================================================
- * 6. MAIN SIMULATION FUNCTION
- * ============================================================================
- */
-
-void run_simulation(double lambda, int num_tellers)
-{
-    printf("\n--- Starting 8-Hour (480 Minute) Simulation ---\n");
-    printf("     Avg. Arrivals / Min (Lambda): %.2f\n", lambda);
-    printf("     Number of Tellers: %d\n", num_tellers);
-    printf("--------------------------------------------------\n");
-
-    // 1. --- Initialize all simulation components ---
-
-    // Seed the random number generator
-    srand(time(NULL));
-
-    // Create the bank queue
-    Queue *bank_queue = create_queue();
-
-    // Create the dynamic array for storing wait times
-    WaitTimeStorage *storage = create_storage();
-
-    // Create the array of tellers
-    Teller *tellers = (Teller *)malloc(num_tellers * sizeof(Teller));
-    if (tellers == NULL) {
-        perror("Failed to allocate memory for tellers");
-        exit(EXIT_FAILURE);
-    }
-    // Initialize all tellers to be free
-    for (int i = 0; i < num_tellers; i++)
-    {
-        tellers[i].is_busy = 0;
-        tellers[i].remaining_service_time = 0;
-    }
-
-    // Statistics trackers
-    int total_arrivals = 0;
-
-    // 2. --- Run the main simulation loop ---
-    for (int current_minute = 0; current_minute < SIMULATION_MINUTES; current_minute++)
-    {
-        // --- Step 1: Handle Tellers (Decrement service time, free them up) ---
-        for (int t = 0; t < num_tellers; t++)
-        {
-            if (tellers[t].is_busy)
-            {
-                tellers[t].remaining_service_time--;
-                if (tellers[t].remaining_service_time == 0)
-                {
-                    tellers[t].is_busy = 0;
-                }
-            }
-        }
-
-        // --- Step 2: Handle New Customer Arrivals ---
-        int new_arrivals = get_poisson_random(lambda);
-        total_arrivals += new_arrivals;
-        for (int i = 0; i < new_arrivals; i++)
-        {
-            enqueue(bank_queue, current_minute);
-        }
-
-        // --- Step 3: Assign Free Tellers to Waiting Customers ---
-        for (int t = 0; t < num_tellers; t++)
-        {
-            // If this teller is free AND there's someone in the queue
-            if (!tellers[t].is_busy && !is_empty(bank_queue))
-            {
-                // 1. Dequeue the next customer
-                Customer *served_customer = dequeue(bank_queue);
-
-                // 2. Calculate and store their wait time
-                int wait_time = current_minute - served_customer->arrival_minute;
-                add_wait_time(storage, wait_time);
-
-                // 3. Occupy the teller
-                tellers[t].is_busy = 1;
-                tellers[t].remaining_service_time = get_service_time();
-
-                // 4. Free the customer struct (we are done with it)
-                free(served_customer);
-            }
-        }
-    } // --- End of simulation loop ---
-
-    printf("... Simulation complete.\n\n");
-
-    // 3. --- Post-Simulation Analysis & Report ---
-    printf("========== 📊 FINAL SIMULATION REPORT 📊 ==========\n");
-    printf("\n--- Simulation Summary ---\n");
-    printf("Total Customers Arrived: %d\n", total_arrivals);
-    printf("Total Customers Served:  %d\n", storage->count);
-    printf("Customers Left in Queue: %d\n", bank_queue->customer_count);
-
-    if (storage->count == 0)
-    {
-        printf("\nNo customers were served. Cannot generate wait-time statistics.\n");
-    }
-    else
-    {
-        printf("\n--- Wait Time Analysis (in minutes) ---\n");
-
-        // Sort the data IN-PLACE. This is crucial for Median and Max.
-        qsort(storage->wait_times, storage->count, sizeof(int), compare_int);
-
-        // Calculate all statistics
-        double mean = get_mean(storage->wait_times, storage->count);
-        double median = get_median(storage->wait_times, storage->count);
-        int mode = get_mode(storage->wait_times, storage->count);
-        double std_dev = get_std_dev(storage->wait_times, storage->count, mean);
-        int max_wait = get_max_wait(storage->wait_times, storage->count);
-
-        // Print the report
-        printf("Mean (Average) Wait: %.2f minutes\n", mean);
-        printf("Median Wait:         %.1f minutes\n", median);
-        printf("Mode Wait:           %d minutes\n", mode);
-        printf("Standard Deviation:  %.2f minutes\n", std_dev);
-        printf("Longest Wait Time:   %d minutes\n", max_wait);
-    }
-    printf("===================================================\n");
-
-
-    // 4. --- Clean up all allocated memory ---
-    free(tellers);
-    free_queue(bank_queue);
-    free_storage(storage);
-}
-
-/*
- * ============================================================================
- * 7. MAIN FUNCTION
- * ============================================================================
- */
-
-int main()
-{
-    double lambda;
-    int num_tellers;
-
-    printf("--- 🏦 Welcome to the Bank Queue Simulator ---\n");
-    printf("This program will simulate an 8-hour bank day.\n\n");
-
-    // Get Lambda from user
-    printf("Enter the average number of customers arriving *per minute* (lambda): ");
-    if (scanf("%lf", &lambda) != 1 || lambda <= 0) {
-        printf("Invalid input. Please enter a positive number.\n");
-        return 1;
-    }
-
-    // Get number of tellers from user
-    printf("Enter the number of tellers working: ");
-    if (scanf("%d", &num_tellers) != 1 || num_tellers <= 0) {
-        printf("Invalid input. Please enter a positive number of tellers.\n");
-        return 1;
-    }
-
-    // Run the main simulation
-    run_simulation(lambda, num_tellers);
-
-    return 0;
-}
\ No newline at end of file
+
+
+#define _POSIX_C_SOURCE 200809L // For clock_gettime, mmap and friends under -std=c11
+#include <stdio.h>
+#include <stdlib.h> // For malloc, free, realloc, qsort
+#include <math.h>   // For exp, sqrt, pow (for Poisson and Std Dev)
+#include <time.h>   // For time(NULL) as the default seed and clock_gettime for benchmarks
+#include <string.h> // For memset (used for mode calculation)
+#include <limits.h> // For INT_MAX
+#include <errno.h>  // For range errors from strtol
+#include <stdint.h> // For uint64_t random number generator state
+#include <pthread.h>   // For running replications on worker threads
+#include <stdatomic.h> // For the shared task counter of the worker threads
+#include <unistd.h>    // For sysconf (number of online CPUs) and close
+#include <fcntl.h>     // For open (memory-mapped service-time files)
+#include <sys/mman.h>  // For mmap and posix_madvise
+#include <sys/stat.h>  // For fstat (size of a mapped file)
+
+// --- Simulation Constants ---
+#define SIMULATION_MINUTES 480 // 8 hours * 60 minutes
+#define MIN_SERVICE_TIME 2     // Minimum minutes to serve a customer
+#define MAX_SERVICE_TIME 3     // Maximum minutes to serve a customer
+#define INITIAL_STORAGE_CAPACITY 100 // Initial size for our dynamic wait-time array
+#define STREAM_EXACT_BITS 11  // Streaming stats: waits below 2^11 minutes get exact bins
+#define STREAM_SUB_BITS 8     // Streaming stats: 2^8 bins per power of two above that
+#define STREAM_EXACT_LIMIT (1 << STREAM_EXACT_BITS)
+#define STREAM_SUB_BINS (1 << STREAM_SUB_BITS)
+#define STREAM_BINS (STREAM_EXACT_LIMIT + (31 - STREAM_EXACT_BITS) * STREAM_SUB_BINS)
+#define TELLER_BLOCK_SIZE 64             // Teller countdowns checked per vector block
+#define TELLER_CLOCK_MAX UINT16_MAX      // Longest service time in whole minutes
+#define SERVICE_FILE_TICKS 60            // --service-file durations are binned to the second
+#define CUSTOMER_SLAB_SIZE 4096      // Customer nodes carved out of each pool allocation
+#define INITIAL_RING_CAPACITY 64     // Initial slots of a ring-buffer queue (power of two)
+#define DEFAULT_BENCH_SAMPLES 100000000 // Draws per benchmark unless --bench-n is given
+#define POISSON_PTRS_THRESHOLD 10.0  // Lambda at which Poisson draws switch from Knuth to PTRS
+#define SCAN_CHUNK_MINUTES 65536     // Minutes per chunk of the parallel max-plus scan
+#define POISSON_TABLE_MAX_SIZE 65536 // Larger Poisson inversion tables fall back to PTRS
+#define RNG_LANES 8                  // Independent xoshiro256** lanes stepped in lockstep
+#define ARRIVAL_WINDOW_TARGET (1 << 18) // Expected arrivals per pre-generated window (--arrivals=sorted)
+#define ARRIVAL_WINDOW_MAX_BITS 16      // Longest window: 2^16 minutes, i.e. two radix-sort passes
+#define ARRIVAL_PROFILE_STEP 60         // Default minutes per --profile multiplier (hourly)
+#define RADIX_SORT_MIN_KEYS 64          // Fewer keys are insertion-sorted: a radix pass clears 256 counters
+#define TRACE_MAGIC "BANKARR1"          // First 8 bytes of a binary arrival trace
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HOST_LITTLE_ENDIAN 1            // SWAR digit parsing and binary traces read bytes in place
+#else
+#define HOST_LITTLE_ENDIAN 0
+#endif
+#define JOURNEY_MAGIC "BANKJRN1"        // First 8 bytes of a --journey file
+#define JOURNEY_BUFFER_RECORDS 65536    // Records per journey buffer (1 MB); two alternate
+#define JOURNEY_BENCH_ROUNDS 5          // --bench=journey keeps the best of this many runs each way
+
+/*
+ * ============================================================================
+ * 1. STRUCT DEFINITIONS
+ * ============================================================================
+ */
+
+/**
+ * @brief A single customer in the queue. This is a node in our linked list.
+ */
+typedef struct Customer
+{
+    int arrival_minute;     // The minute the customer entered the queue
+    struct Customer *next;  // Pointer to the next customer in line
+} Customer;
+
+/**
+ * @brief One block of Customer nodes allocated in a single malloc.
+ */
+typedef struct CustomerSlab
+{
+    struct CustomerSlab *next;            // Previously allocated slab
+    Customer nodes[CUSTOMER_SLAB_SIZE];
+} CustomerSlab;
+
+/**
+ * @brief Recycles Customer nodes for the queues of one simulation. Nodes
+ * come from a free list refilled in whole slabs, so once the pool has grown
+ * to the deepest queue of the run no further heap allocation happens.
+ */
+typedef struct CustomerPool
+{
+    Customer *free_list;  // Nodes ready to be reused, linked through next
+    CustomerSlab *slabs;  // Every slab allocated so far
+} CustomerPool;
+
+/**
+ * @brief Selects how a Queue stores its waiting customers.
+ */
+typedef enum QueueType
+{
+    QUEUE_LIST, // Linked list of pooled Customer nodes
+    QUEUE_RING, // Growable circular array of arrival minutes
+    QUEUE_RLE   // Growable circular array of (arrival minute, count) runs
+} QueueType;
+
+/**
+ * @brief A run of customers who all arrived in the same minute.
+ */
+typedef struct QueueRun
+{
+    int arrival_minute; // The minute every customer of the run arrived
+    int count;          // How many of them are still waiting
+} QueueRun;
+
+/**
+ * @brief The queue manager. All backends give O(1) enqueue and dequeue.
+ * The list backend holds pointers to the front and rear of the linked list;
+ * the ring backend keeps the arrival minutes contiguously in a circular
+ * array that doubles when full; the run-length backend does the same with
+ * one QueueRun per arrival minute, so a minute's whole batch costs 8 bytes.
+ */
+typedef struct Queue
+{
+    QueueType type;
+    Customer *front; // Pointer to the head of the list
+    Customer *rear;  // Pointer to the tail of the list
+    int customer_count;
+    CustomerPool *pool; // Where nodes come from and go back to
+    int *ring;          // Ring backend: arrival minutes, oldest at ring[head]
+    QueueRun *runs;     // Run-length backend: runs, oldest at runs[head]
+    int ring_capacity;  // Ring/run-length backends: number of slots, always a power of two
+    int head;           // Ring/run-length backends: slot at the front
+    int run_count;      // Run-length backend: number of runs in use
+} Queue;
+
+/**
+ * @brief Represents a single bank teller.
+ */
+typedef struct Teller
+{
+    int is_busy;                // 0 = free, 1 = busy
+    int remaining_service_time; // Minutes left until this teller is free
+} Teller;
+
+/**
+ * @brief Minutes left until a teller is free, 0 meaning idle. The engines
+ * keep one contiguous array of these (structure of arrays) instead of an
+ * array of Teller, so the per-minute countdown touches two bytes per
+ * teller and vectorizes; Teller is kept as the reference layout for
+ * --bench=tellers. Service times are capped at TELLER_CLOCK_MAX minutes.
+ */
+typedef uint16_t TellerClock;
+
+/**
+ * @brief Selects the distribution service times are drawn from.
+ */
+typedef enum ServiceType
+{
+    SERVICE_UNIFORM,     // Uniform between MIN_SERVICE_TIME and MAX_SERVICE_TIME (original)
+    SERVICE_EXPONENTIAL, // Exponential with the given mean, by ziggurat
+    SERVICE_LOGNORMAL,   // Lognormal with the given mean and standard deviation, by ziggurat
+    SERVICE_EMPIRICAL    // Weighted list of observed service times, by alias table
+} ServiceType;
+
+/**
+ * @brief Layer tables of Marsaglia and Tsang's ziggurat method for the
+ * standard normal (128 layers) and standard exponential (256 layers).
+ * A draw almost always costs one 64-bit random number, one compare and
+ * one multiply; the rare rejections fall back to exact tests.
+ */
+typedef struct Ziggurat
+{
+    uint32_t normal_k[128];
+    double normal_w[128];
+    double normal_f[128];
+    uint32_t exp_k[256];
+    double exp_w[256];
+    double exp_f[256];
+} Ziggurat;
+
+/**
+ * @brief Walker's alias method in Vose's construction: n columns, each
+ * holding its own outcome with probability prob[i] and alias[i] otherwise,
+ * so any discrete distribution is sampled with one uniform in O(1).
+ */
+typedef struct AliasTable
+{
+    int size;
+    double *prob; // Chance that column i yields i rather than alias[i]
+    int *alias;   // Outcome of column i when it does not yield i
+} AliasTable;
+
+/**
+ * @brief A service-time distribution chosen at runtime with --service.
+ * All-zero is the original uniform distribution.
+ */
+typedef struct ServiceDistribution
+{
+    ServiceType type;
+    double mean;          // Exponential and lognormal: mean in minutes
+    double mu, sigma;     // Lognormal: mean and standard deviation of log(service)
+    const Ziggurat *zig;  // Exponential and lognormal: shared layer tables
+    double *values;       // Empirical: observed service times in minutes
+    AliasTable *alias;    // Empirical: weights of values
+    long long observations; // Empirical: durations read by --service-file (0 if given inline)
+    long long clamped;      // Empirical: file durations outside the bins, moved to the nearest one
+} ServiceDistribution;
+
+/**
+ * @brief Selects how wait-time statistics are computed for the report.
+ */
+typedef enum StatsType
+{
+    STATS_SORT,      // qsort the wait times, then scan them
+    STATS_HISTOGRAM, // Count each wait value, then scan the counts
+    STATS_STREAM     // Fold each wait into fixed-size accumulators; nothing is stored
+} StatsType;
+
+/**
+ * @brief A counting histogram of wait times. Bins below exact_limit hold
+ * exactly one wait value each (counts[w] customers waited w minutes); bins
+ * from exact_limit up are log-linear, STREAM_SUB_BINS per power of two.
+ */
+typedef struct WaitHistogram
+{
+    long long *counts; // Number of customers per bin
+    int size;          // Number of bins
+    int exact_limit;   // Bins below this index are exact wait values
+    long long total;   // Sum of all counts
+} WaitHistogram;
+
+/**
+ * @brief A dynamic array to store the wait times of all *served* customers.
+ * This will grow as needed using realloc().
+ *
+ * In streaming mode nothing is stored: each wait is folded into running
+ * accumulators (Welford mean/variance, max, fixed log-linear histogram), so
+ * memory stays constant however many customers are simulated.
+ */
+typedef struct WaitTimeStorage
+{
+    int *wait_times;  // Pointer to the dynamically allocated array of wait times (NULL when streaming)
+    long long count;  // Current number of wait times stored (or folded in)
+    long long capacity; // Current total capacity of the array
+    int streaming;    // 1 = fold waits into the accumulators below instead of storing them
+    double mean;      // Streaming: running mean
+    double m2;        // Streaming: running sum of squared deviations from the mean
+    int max;          // Streaming: longest wait
+    WaitHistogram hist; // Streaming: fixed-size histogram for median, mode and percentiles
+} WaitTimeStorage;
+
+/**
+ * @brief The state of one random number stream (xoshiro256**). Every
+ * simulation run owns its own stream, so runs on different threads never
+ * share generator state.
+ */
+typedef struct Rng
+{
+    uint64_t s[4]; // Generator state; never all zero
+} Rng;
+
+/**
+ * @brief RNG_LANES independent xoshiro256** generators stored lane-major,
+ * so stepping all of them is one loop the compiler turns into SIMD code.
+ */
+typedef struct RngLanes
+{
+    uint64_t s[4][RNG_LANES]; // s[i][lane] is word i of that lane's state
+} RngLanes;
+
+/**
+ * @brief Selects how an ArrivalSource generates arrival minutes.
+ */
+typedef enum ArrivalMode
+{
+    ARRIVALS_GAPS,   // Geometric gap to the next non-empty minute, then its batch size
+    ARRIVALS_SORTED, // Per window: Poisson total, uniform minutes, radix sort
+    ARRIVALS_TRACE   // Replayed from a recorded log (--trace); set by the source itself
+} ArrivalMode;
+
+/**
+ * @brief A recorded arrival log, memory-mapped read-only and shared by
+ * every run that replays it. Text logs hold one timestamp in seconds per
+ * line (the first field of a CSV row; lines that do not start with a digit
+ * are skipped). Binary logs start with TRACE_MAGIC followed by
+ * little-endian IEEE doubles, also seconds. Either way timestamps must be
+ * non-decreasing, and the first arrival's minute becomes minute 0.
+ */
+typedef struct ArrivalTrace
+{
+    const char *path;
+    const char *data;       // Mapped file
+    size_t size;
+    int binary;             // 1 for TRACE_MAGIC + doubles, 0 for text
+    double origin;          // Seconds at minute 0: the first timestamp rounded down to a minute
+    long long span_minutes; // Minutes from minute 0 through the last arrival's minute
+} ArrivalTrace;
+
+/**
+ * @brief A read position in an ArrivalTrace; each run keeps its own, so
+ * replications replay the log independently without copying it.
+ */
+typedef struct TraceCursor
+{
+    const ArrivalTrace *trace;
+    size_t offset;          // Next byte to read
+    double last;            // Previous timestamp, to reject unsorted logs
+    long long line;         // Text lines read so far, for error messages (-1 = unknown)
+} TraceCursor;
+
+/**
+ * @brief A time-varying arrival rate: minute m of the day arrives at rate
+ * lambda * factors[(m / step_minutes) % num_steps], so the profile repeats
+ * over horizons longer than one cycle.
+ */
+typedef struct ArrivalProfile
+{
+    int num_steps;    // Multipliers in one cycle (0 = constant rate lambda)
+    int step_minutes; // Minutes each multiplier lasts
+    double *factors;  // Multipliers of lambda; non-negative, at least one positive
+} ArrivalProfile;
+
+/**
+ * @brief A Poisson distribution, optionally truncated below, tabulated for
+ * sampling by inversion. The guide table maps a uniform u to the first
+ * entry whose CDF could reach it, so a draw is one uniform, one lookup and
+ * on average about one comparison. Tables are built once per (lambda,
+ * min_value) and shared through a global cache; they are never modified
+ * afterwards, so any number of threads can read them.
+ */
+typedef struct PoissonTable
+{
+    double lambda;
+    int min_value;             // 0 for Poisson, 1 for arrival batches (at least one customer)
+    int lo;                    // Value of cdf[0]; the tails beyond lo..lo+size-1 are below 1e-30
+    int size;                  // Entries in cdf and guide; 0 if the table would be too large
+    double *cdf;               // cdf[i] = P(X <= lo + i | X >= min_value), cdf[size - 1] == 1
+    int *guide;                // guide[j] = first i with cdf[i] >= j / size
+    struct PoissonTable *next; // Next table in the cache
+} PoissonTable;
+
+/**
+ * @brief Produces a day's arrivals as (minute, batch size) pairs, skipping
+ * minutes without arrivals. It draws from its own substream, so every
+ * engine sees the same customers for the same stream regardless of how
+ * many service times it draws in between.
+ */
+typedef struct ArrivalSource
+{
+    Rng rng;                         // Arrival substream, 2^192 draws away from the service draws
+    double lambda;                   // Average arrivals per minute
+    ArrivalMode mode;
+    const PoissonTable *batch_table; // Gaps mode: zero-truncated batch sizes, or NULL to use PTRS
+    long long minute;                // Minute of the next batch
+    int count;                       // Customers arriving in that minute (at least 1)
+
+    // Sorted mode: arrivals are generated a window of 2^window_bits minutes at a time
+    RngLanes *lanes;                 // Uniform generator for arrival minutes
+    uint32_t *window;                // Arrival minutes of the window, relative to its start, ascending
+    uint32_t *scratch;               // Radix-sort buffer, same size as window
+    long long window_capacity;       // Slots in window and scratch
+    long long window_start;          // First minute of the window
+    int window_bits;
+    long long window_size;           // Arrivals in the window
+    long long window_pos;            // Next arrival of the window to hand out
+
+    // Time-varying rate (--profile): source minute m lies in step
+    // ((origin + m) / step_minutes) % num_steps of the profile
+    int num_steps;                   // 0 for a constant rate
+    int step_minutes;
+    long long origin;                // Minute of the day that is this source's minute 0
+    int step;                        // Profile step in force just before step_end
+    long long step_end;              // Source minute at which that step ends
+    double *step_rates;              // lambda times each step's multiplier
+    const PoissonTable **step_tables; // Gaps mode: batch-size table per step, NULL entries use PTRS
+    long long window_length;         // Sorted mode: minutes the window covers (shorter at step ends)
+
+    // Trace mode: batches are read off the log one record ahead
+    TraceCursor cursor;
+    long long pending_minute;        // Minute of the next unread record, LLONG_MAX at the end
+} ArrivalSource;
+
+/**
+ * @brief The wait-time statistics shown in a report.
+ */
+typedef struct WaitSummary
+{
+    long long count; // Number of served customers
+    double mean;
+    double median;
+    int mode;
+    double std_dev;
+    int p95;         // 95th percentile (nearest rank)
+    int max;
+} WaitSummary;
+
+/**
+ * @brief Selects how run_simulation advances simulated time.
+ */
+typedef enum EngineType
+{
+    ENGINE_MINUTE,      // Step through every minute and scan every teller
+    ENGINE_EVENT,       // Jump straight from one scheduled event to the next
+    ENGINE_LINDLEY,     // Kiefer-Wolfowitz recursion over customers; FIFO, identical tellers only
+    ENGINE_SCAN,        // Lindley recursion split into chunks and combined by a parallel max-plus scan
+    ENGINE_CONTINUOUS   // Real-valued arrival and service times; waits reported in seconds
+} EngineType;
+
+/**
+ * @brief The effect of a stretch of customers on a single teller's free
+ * minute F, as the max-plus affine map F -> max(F + shift, floor). Two
+ * stretches compose into another such map, which is what lets the scan
+ * engine process a long day in independent chunks.
+ */
+typedef struct TellerTransfer
+{
+    long long shift; // Total service time of the stretch
+    long long floor; // Free minute if the teller were free from the start; LLONG_MIN if no customers
+} TellerTransfer;
+
+/**
+ * @brief Selects how the minute-stepped engine finds tellers whose service
+ * ends this minute.
+ */
+typedef enum TellerMode
+{
+    TELLERS_COUNTDOWN, // Decrement every busy teller's remaining time each minute
+    TELLERS_HEAP       // Pop tellers from a min-heap keyed by absolute completion minute
+} TellerMode;
+
+/**
+ * @brief Everything needed to describe one simulation run.
+ */
+typedef struct SimConfig
+{
+    double lambda;    // Average customer arrivals per minute
+    int num_tellers;  // Number of tellers working in parallel
+    int sim_minutes;  // Length of the simulated horizon in minutes
+    EngineType engine;
+    QueueType queue_type;
+    StatsType stats_type;
+    TellerMode teller_mode;
+    ArrivalMode arrival_mode;
+    uint64_t seed;      // Base seed; replication r uses stream r of this seed
+    int replications;   // Number of independent days to simulate
+    int num_threads;    // Worker threads for replications (0 = one per CPU)
+    ServiceDistribution service; // Service-time distribution ({0} = uniform)
+    ArrivalProfile profile;      // Time-varying arrival rate ({0} = constant lambda)
+    const ArrivalTrace *trace;   // Recorded arrivals to replay instead of drawing them, or NULL
+    const char *journey_path;    // File to record every served customer's journey in, or NULL
+} SimConfig;
+
+/**
+ * @brief An inclusive range of parameter values: first, first + step, ...
+ * up to last. A single value is a range with first == last.
+ */
+typedef struct SweepRange
+{
+    double first;
+    double last;
+    double step;
+} SweepRange;
+
+/**
+ * @brief The grid of (lambda, num_tellers) points covered by a sweep.
+ */
+typedef struct SweepSpec
+{
+    SweepRange lambda;
+    SweepRange tellers;
+    const char *output_path; // CSV destination, or NULL for stdout
+} SweepSpec;
+
+/**
+ * @brief Which microbenchmark to run instead of a simulation, if any.
+ */
+typedef struct BenchSpec
+{
+    const char *name;  // Benchmark name, or NULL to simulate as usual
+    long long samples; // Operations to time per case
+    int validate;      // 1 to cross-check every engine instead of simulating
+} BenchSpec;
+
+/**
+ * @brief One served customer's journey as written by --journey: all times
+ * in ticks from minute 0 (see JourneyHeader), teller ids from 0.
+ */
+typedef struct JourneyRecord
+{
+    uint32_t arrival; // When the customer joined the queue
+    uint32_t start;   // When a teller started serving them
+    uint32_t end;     // When that service ends (may be past the horizon)
+    uint32_t teller;  // Which teller served them
+} JourneyRecord;
+
+/**
+ * @brief The fixed 24-byte header of a --journey file, followed by one
+ * JourneyRecord per served customer in order of service start. Fields
+ * are in the machine's native byte order.
+ */
+typedef struct JourneyHeader
+{
+    char magic[8];             // JOURNEY_MAGIC
+    uint32_t ticks_per_minute; // 1 for the minute-based engines, 60 (seconds) for continuous
+    uint32_t record_size;      // sizeof(JourneyRecord), so readers can check the layout
+    uint64_t seed;             // Seed of the recorded run
+} JourneyHeader;
+
+/**
+ * @brief Writes journey records through two buffers: the simulation fills
+ * one while a background thread writes the other, so the engine only
+ * waits if the disk falls a whole buffer behind.
+ */
+typedef struct JourneyWriter
+{
+    FILE *file;
+    JourneyRecord *buffers[2];
+    JourneyRecord *fill;       // Buffer the simulation is filling
+    int fill_count;            // Records in `fill`
+    int pending_count;         // Records in the other buffer awaiting the writer (0 = free)
+    int closing;               // Set once the last buffer has been handed over
+    int failed;                // Set by the writer thread if a write fails
+    long long records;         // Records handed over so far
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;    // Signalled whenever pending_count or closing changes
+} JourneyWriter;
+
+/**
+ * @brief The raw outcome of one simulation run, before any statistics.
+ */
+typedef struct SimResult
+{
+    long long total_arrivals;  // Customers who arrived during the horizon
+    long long customers_left;  // Customers still waiting when the horizon ended
+    WaitTimeStorage *storage;  // Wait times of every served customer
+    JourneyWriter *journey;    // Where every served customer's journey goes, or NULL
+} SimResult;
+
+/**
+ * @brief A stack of the indices of idle tellers, maintained on every
+ * busy/free transition so that finding a free teller never scans.
+ */
+typedef struct IdleTellers
+{
+    int *stack; // Indices of idle tellers; the top is stack[count - 1]
+    int count;  // Number of idle tellers
+} IdleTellers;
+
+/**
+ * @brief The kinds of entries kept in the future-event list. The numeric
+ * order matters: at the same minute, completions are handled before
+ * arrivals, matching the step order of the minute-stepped loop.
+ */
+typedef enum EventType
+{
+    EVENT_COMPLETION = 0, // A teller finishes serving a customer
+    EVENT_ARRIVAL = 1     // A batch of customers walks in
+} EventType;
+
+/**
+ * @brief A single scheduled event in the future-event list.
+ */
+typedef struct Event
+{
+    int time;  // Minute at which the event fires
+    int type;  // One of EventType
+    int data;  // Teller index for completions, batch size for arrivals
+} Event;
+
+/**
+ * @brief The future-event list: a binary min-heap ordered by (time, type).
+ */
+typedef struct EventHeap
+{
+    Event *events; // Heap-ordered array of pending events
+    int count;     // Number of pending events
+    int capacity;  // Current total capacity of the array
+} EventHeap;
+
+/*
+ * ============================================================================
+ * 2. QUEUE MANAGEMENT FUNCTIONS (Linked List, Ring Buffer and Run-Length Implementations)
+ * ============================================================================
+ */
+
+/**
+ * @brief Creates and initializes a new, empty pool of Customer nodes.
+ * @return Pointer to the newly allocated CustomerPool.
+ */
+CustomerPool *create_pool()
+{
+    CustomerPool *pool = (CustomerPool *)malloc(sizeof(CustomerPool));
+    if (pool == NULL)
+    {
+        perror("Failed to allocate memory for customer pool");
+        exit(EXIT_FAILURE);
+    }
+    pool->free_list = NULL;
+    pool->slabs = NULL;
+    return pool;
+}
+
+/**
+ * @brief Takes a node from the pool, allocating a new slab if it is empty.
+ */
+Customer *take_customer(CustomerPool *pool)
+{
+    if (pool->free_list == NULL)
+    {
+        CustomerSlab *slab = (CustomerSlab *)malloc(sizeof(CustomerSlab));
+        if (slab == NULL)
+        {
+            perror("Failed to allocate memory for new customers");
+            exit(EXIT_FAILURE);
+        }
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+
+        // Thread the new nodes onto the free list
+        for (int i = 0; i < CUSTOMER_SLAB_SIZE - 1; i++)
+        {
+            slab->nodes[i].next = &slab->nodes[i + 1];
+        }
+        slab->nodes[CUSTOMER_SLAB_SIZE - 1].next = NULL;
+        pool->free_list = &slab->nodes[0];
+    }
+
+    Customer *customer = pool->free_list;
+    pool->free_list = customer->next;
+    return customer;
+}
+
+/**
+ * @brief Returns a node to the pool for reuse. O(1), no free() involved.
+ */
+void return_customer(CustomerPool *pool, Customer *customer)
+{
+    customer->next = pool->free_list;
+    pool->free_list = customer;
+}
+
+/**
+ * @brief Frees every slab of the pool and the pool itself. Any queue still
+ * using the pool must not be used afterwards.
+ */
+void free_pool(CustomerPool *pool)
+{
+    CustomerSlab *slab = pool->slabs;
+    while (slab != NULL)
+    {
+        CustomerSlab *temp = slab;
+        slab = slab->next;
+        free(temp);
+    }
+    free(pool);
+}
+
+/**
+ * @brief Gets the human-readable name of a queue backend.
+ */
+const char *get_queue_name(QueueType type)
+{
+    if (type == QUEUE_RING) return "ring buffer";
+    if (type == QUEUE_RLE) return "run-length";
+    return "linked list";
+}
+
+/**
+ * @brief Creates and initializes a new, empty queue.
+ * @param type Which storage backend to use.
+ * @param pool The pool its Customer nodes are drawn from (list backend only).
+ * @return Pointer to the newly allocated Queue.
+ */
+Queue *create_queue(QueueType type, CustomerPool *pool)
+{
+    // Allocate memory for the queue manager struct
+    Queue *q = (Queue *)malloc(sizeof(Queue));
+    if (q == NULL)
+    {
+        perror("Failed to allocate memory for queue");
+        exit(EXIT_FAILURE);
+    }
+    q->front = NULL;
+    q->rear = NULL;
+    q->customer_count = 0;
+    q->type = type;
+    q->pool = pool;
+    q->ring = NULL;
+    q->runs = NULL;
+    q->ring_capacity = 0;
+    q->head = 0;
+    q->run_count = 0;
+
+    if (type == QUEUE_RING)
+    {
+        q->ring = (int *)malloc(INITIAL_RING_CAPACITY * sizeof(int));
+    }
+    else if (type == QUEUE_RLE)
+    {
+        q->runs = (QueueRun *)malloc(INITIAL_RING_CAPACITY * sizeof(QueueRun));
+    }
+    if (type != QUEUE_LIST)
+    {
+        if (q->ring == NULL && q->runs == NULL)
+        {
+            perror("Failed to allocate memory for queue ring");
+            exit(EXIT_FAILURE);
+        }
+        q->ring_capacity = INITIAL_RING_CAPACITY;
+    }
+    return q;
+}
+
+/**
+ * @brief Checks if the queue is empty.
+ * @return 1 (true) if empty, 0 (false) if not.
+ */
+int is_empty(Queue *q)
+{
+    return (q->customer_count == 0);
+}
+
+/**
+ * @brief List backend of enqueue: links a pooled node after the rear.
+ */
+void list_enqueue(Queue *q, int arrival_minute)
+{
+    // 1. Take a node for the new customer from the pool
+    Customer *new_customer = take_customer(q->pool);
+    new_customer->arrival_minute = arrival_minute;
+    new_customer->next = NULL;
+
+    // 2. Link the new customer to the end of the list
+    if (is_empty(q))
+    {
+        // If queue is empty, new customer is both front and rear
+        q->front = new_customer;
+        q->rear = new_customer;
+    }
+    else
+    {
+        // Otherwise, link the current rear to the new customer
+        q->rear->next = new_customer;
+        // And update the rear to be the new customer
+        q->rear = new_customer;
+    }
+    q->customer_count++;
+}
+
+/**
+ * @brief Doubles a full circular array of `capacity` elements whose front is
+ * at slot `head`, moving the elements so that the front lands in slot 0.
+ * @return The new array; the old one has been freed.
+ */
+void *grow_circular(void *array, int capacity, int head, size_t element_size)
+{
+    char *old_array = (char *)array;
+    char *new_array = (char *)malloc(2 * (size_t)capacity * element_size);
+    if (new_array == NULL)
+    {
+        perror("Failed to re-allocate memory for queue ring");
+        exit(EXIT_FAILURE);
+    }
+
+    // Copy the two stretches of the circular array: head..end, then 0..head
+    size_t first_part = (size_t)(capacity - head) * element_size;
+    memcpy(new_array, old_array + (size_t)head * element_size, first_part);
+    memcpy(new_array + first_part, old_array, (size_t)head * element_size);
+
+    free(old_array);
+    return new_array;
+}
+
+/**
+ * @brief Ring backend: doubles the circular array once it is full.
+ */
+void ring_grow(Queue *q)
+{
+    q->ring = (int *)grow_circular(q->ring, q->ring_capacity, q->head, sizeof(int));
+    q->ring_capacity *= 2;
+    q->head = 0;
+}
+
+/**
+ * @brief Ring backend of enqueue: writes the arrival minute into the slot
+ * after the current rear, growing the array first if it is full.
+ */
+void ring_enqueue(Queue *q, int arrival_minute)
+{
+    if (q->customer_count == q->ring_capacity)
+    {
+        ring_grow(q);
+    }
+    q->ring[(q->head + q->customer_count) & (q->ring_capacity - 1)] = arrival_minute;
+    q->customer_count++;
+}
+
+/**
+ * @brief Run-length backend of enqueue: bumps the count of the rear run if
+ * it arrived in the same minute, otherwise starts a new run.
+ */
+void rle_enqueue(Queue *q, int arrival_minute)
+{
+    if (q->run_count > 0)
+    {
+        QueueRun *rear = &q->runs[(q->head + q->run_count - 1) & (q->ring_capacity - 1)];
+        if (rear->arrival_minute == arrival_minute)
+        {
+            rear->count++;
+            q->customer_count++;
+            return;
+        }
+    }
+
+    if (q->run_count == q->ring_capacity)
+    {
+        q->runs = (QueueRun *)grow_circular(q->runs, q->ring_capacity, q->head, sizeof(QueueRun));
+        q->ring_capacity *= 2;
+        q->head = 0;
+    }
+    QueueRun *run = &q->runs[(q->head + q->run_count) & (q->ring_capacity - 1)];
+    run->arrival_minute = arrival_minute;
+    run->count = 1;
+    q->run_count++;
+    q->customer_count++;
+}
+
+/**
+ * @brief Adds a new customer to the REAR of the queue.
+ * @param q The queue to modify.
+ * @param arrival_minute The simulation minute the customer arrived.
+ */
+void enqueue(Queue *q, int arrival_minute)
+{
+    if (q->type == QUEUE_RING)
+    {
+        ring_enqueue(q, arrival_minute);
+    }
+    else if (q->type == QUEUE_RLE)
+    {
+        rle_enqueue(q, arrival_minute);
+    }
+    else
+    {
+        list_enqueue(q, arrival_minute);
+    }
+}
+
+/**
+ * @brief List backend of enqueue_n: links k pooled nodes into a chain and
+ * splices the chain onto the rear in one step.
+ */
+void list_enqueue_n(Queue *q, int arrival_minute, int k)
+{
+    Customer *first = take_customer(q->pool);
+    first->arrival_minute = arrival_minute;
+    Customer *last = first;
+    for (int i = 1; i < k; i++)
+    {
+        Customer *next = take_customer(q->pool);
+        next->arrival_minute = arrival_minute;
+        last->next = next;
+        last = next;
+    }
+    last->next = NULL;
+
+    if (is_empty(q))
+    {
+        q->front = first;
+    }
+    else
+    {
+        q->rear->next = first;
+    }
+    q->rear = last;
+    q->customer_count += k;
+}
+
+/**
+ * @brief Ring backend of enqueue_n: grows the array once to fit all k
+ * customers, then fills the (at most two) free stretches.
+ */
+void ring_enqueue_n(Queue *q, int arrival_minute, int k)
+{
+    while (q->customer_count + k > q->ring_capacity)
+    {
+        ring_grow(q);
+    }
+    int mask = q->ring_capacity - 1;
+    int tail = (q->head + q->customer_count) & mask;
+    int first_part = (q->ring_capacity - tail < k) ? q->ring_capacity - tail : k;
+    for (int i = 0; i < first_part; i++)
+    {
+        q->ring[tail + i] = arrival_minute;
+    }
+    for (int i = first_part; i < k; i++)
+    {
+        q->ring[i - first_part] = arrival_minute;
+    }
+    q->customer_count += k;
+}
+
+/**
+ * @brief Adds k customers who arrived in the same minute to the REAR of the
+ * queue in one operation. For the run-length backend this costs the same
+ * as a single enqueue.
+ * @param k Number of customers; nothing happens if k <= 0.
+ */
+void enqueue_n(Queue *q, int arrival_minute, int k)
+{
+    if (k <= 0)
+    {
+        return;
+    }
+    if (q->type == QUEUE_RING)
+    {
+        ring_enqueue_n(q, arrival_minute, k);
+    }
+    else if (q->type == QUEUE_RLE)
+    {
+        // Same as rle_enqueue, with the run count raised by k instead of 1
+        rle_enqueue(q, arrival_minute);
+        q->runs[(q->head + q->run_count - 1) & (q->ring_capacity - 1)].count += k - 1;
+        q->customer_count += k - 1;
+    }
+    else
+    {
+        list_enqueue_n(q, arrival_minute, k);
+    }
+}
+
+/**
+ * @brief List backend of dequeue: unlinks the front node and returns it to
+ * the pool. The queue must not be empty.
+ */
+int list_dequeue(Queue *q)
+{
+    // 1. Get the customer at the front
+    Customer *served_customer = q->front;
+
+    // 2. Move the front pointer to the next customer
+    q->front = q->front->next;
+
+    // 3. If the queue is now empty, update the rear pointer as well
+    if (q->front == NULL)
+    {
+        q->rear = NULL;
+    }
+
+    q->customer_count--;
+
+    // 4. Recycle the node; only the arrival minute is needed from here on
+    int arrival_minute = served_customer->arrival_minute;
+    return_customer(q->pool, served_customer);
+    return arrival_minute;
+}
+
+/**
+ * @brief Ring backend of dequeue: reads the front slot and advances head.
+ * The queue must not be empty.
+ */
+int ring_dequeue(Queue *q)
+{
+    int arrival_minute = q->ring[q->head];
+    q->head = (q->head + 1) & (q->ring_capacity - 1);
+    q->customer_count--;
+    return arrival_minute;
+}
+
+/**
+ * @brief Run-length backend of dequeue: takes one customer off the front run
+ * and drops the run once it is used up. The queue must not be empty.
+ */
+int rle_dequeue(Queue *q)
+{
+    QueueRun *front = &q->runs[q->head];
+    int arrival_minute = front->arrival_minute;
+    if (--front->count == 0)
+    {
+        q->head = (q->head + 1) & (q->ring_capacity - 1);
+        q->run_count--;
+    }
+    q->customer_count--;
+    return arrival_minute;
+}
+
+/**
+ * @brief Removes the customer at the FRONT of the queue.
+ * @param q The queue to modify.
+ * @return The arrival minute of the removed customer, or -1 if the queue is empty.
+ */
+int dequeue(Queue *q)
+{
+    // 1. Check if queue is empty
+    if (is_empty(q))
+    {
+        return -1;
+    }
+    if (q->type == QUEUE_RING)
+    {
+        return ring_dequeue(q);
+    }
+    if (q->type == QUEUE_RLE)
+    {
+        return rle_dequeue(q);
+    }
+    return list_dequeue(q);
+}
+
+/**
+ * @brief Removes up to k customers from the FRONT of the queue in one
+ * operation, e.g. one for each free teller.
+ * @param arrival_minutes Receives the arrival minutes of the removed
+ * customers in queue order; must have room for k.
+ * @return The number of customers removed (fewer than k if the queue runs out).
+ */
+int dequeue_n(Queue *q, int k, int *arrival_minutes)
+{
+    if (k > q->customer_count) k = (int)q->customer_count;
+    if (k <= 0)
+    {
+        return 0;
+    }
+
+    if (q->type == QUEUE_RING)
+    {
+        // Copy the (at most two) stretches, then advance head once
+        int first_part = (q->ring_capacity - q->head < k) ? q->ring_capacity - q->head : k;
+        memcpy(arrival_minutes, q->ring + q->head, first_part * sizeof(int));
+        memcpy(arrival_minutes + first_part, q->ring, (k - first_part) * sizeof(int));
+        q->head = (q->head + k) & (q->ring_capacity - 1);
+    }
+    else if (q->type == QUEUE_RLE)
+    {
+        // Take whole runs while they fit, then part of the next one
+        int taken = 0;
+        while (taken < k)
+        {
+            QueueRun *front = &q->runs[q->head];
+            int take = (front->count < k - taken) ? front->count : k - taken;
+            for (int i = 0; i < take; i++)
+            {
+                arrival_minutes[taken + i] = front->arrival_minute;
+            }
+            taken += take;
+            front->count -= take;
+            if (front->count == 0)
+            {
+                q->head = (q->head + 1) & (q->ring_capacity - 1);
+                q->run_count--;
+            }
+        }
+    }
+    else
+    {
+        // Walk the k front nodes, then hand the whole stretch back to the
+        // pool with one splice
+        Customer *first = q->front;
+        Customer *last = first;
+        arrival_minutes[0] = first->arrival_minute;
+        for (int i = 1; i < k; i++)
+        {
+            last = last->next;
+            arrival_minutes[i] = last->arrival_minute;
+        }
+        q->front = last->next;
+        if (q->front == NULL)
+        {
+            q->rear = NULL;
+        }
+        last->next = q->pool->free_list;
+        q->pool->free_list = first;
+    }
+
+    q->customer_count -= k;
+    return k;
+}
+
+/**
+ * @brief Releases the queue's storage and frees the queue itself. Remaining
+ * list customers go back to the pool in one step (the whole list is spliced
+ * onto the free list).
+ */
+void free_queue(Queue *q)
+{
+    if (q->front != NULL)
+    {
+        q->rear->next = q->pool->free_list;
+        q->pool->free_list = q->front;
+    }
+    free(q->ring);
+    free(q->runs);
+    free(q);
+}
+
+/**
+ * @brief Gets the bytes of customer storage the queue currently holds on to
+ * (for the list backend, the nodes of its waiting customers).
+ */
+long long get_queue_bytes(Queue *q)
+{
+    if (q->type == QUEUE_RING) return (long long)q->ring_capacity * sizeof(int);
+    if (q->type == QUEUE_RLE) return (long long)q->ring_capacity * sizeof(QueueRun);
+    return (long long)q->customer_count * sizeof(Customer);
+}
+
+/*
+ * ============================================================================
+ * 3. DYNAMIC ARRAY (WaitTimeStorage) FUNCTIONS
+ * ============================================================================
+ */
+
+/**
+ * @brief Gets the streaming-histogram bin of a wait time: the wait itself
+ * below STREAM_EXACT_LIMIT, a log-linear bin (relative width 1/256) above.
+ */
+int get_stream_bin(int wait_time)
+{
+    if (wait_time < STREAM_EXACT_LIMIT) return wait_time;
+    int octave = 31 - __builtin_clz((unsigned)wait_time); // floor(log2(wait_time))
+    int sub_bin = (wait_time >> (octave - STREAM_SUB_BITS)) - STREAM_SUB_BINS;
+    return STREAM_EXACT_LIMIT + (octave - STREAM_EXACT_BITS) * STREAM_SUB_BINS + sub_bin;
+}
+
+/**
+ * @brief Creates and initializes a new, empty storage for wait times.
+ * @param type STATS_STREAM for constant-memory accumulators, anything else
+ * to keep every wait time in the dynamic array.
+ * @return Pointer to the newly allocated WaitTimeStorage.
+ */
+WaitTimeStorage *create_storage(StatsType type)
+{
+    WaitTimeStorage *storage = (WaitTimeStorage *)calloc(1, sizeof(WaitTimeStorage));
+    if (storage == NULL)
+    {
+        perror("Failed to allocate memory for storage");
+        exit(EXIT_FAILURE);
+    }
+
+    if (type == STATS_STREAM)
+    {
+        storage->streaming = 1;
+        storage->hist.size = STREAM_BINS;
+        storage->hist.exact_limit = STREAM_EXACT_LIMIT;
+        storage->hist.counts = (long long *)calloc(STREAM_BINS, sizeof(long long));
+        if (storage->hist.counts == NULL)
+        {
+            perror("Failed to allocate memory for streaming histogram");
+            exit(EXIT_FAILURE);
+        }
+        return storage;
+    }
+
+    // Allocate the initial array to hold wait times
+    storage->wait_times = (int *)malloc(INITIAL_STORAGE_CAPACITY * sizeof(int));
+    if (storage->wait_times == NULL)
+    {
+        perror("Failed to allocate memory for initial wait time array");
+        exit(EXIT_FAILURE);
+    }
+
+    storage->count = 0;
+    storage->capacity = INITIAL_STORAGE_CAPACITY;
+    return storage;
+}
+
+/**
+ * @brief Adds a new wait time to the storage, resizing the array if necessary.
+ * This is the "dynamic" part of the array.
+ * @param storage The storage to modify.
+ * @param wait_time The new wait time to add.
+ */
+void add_wait_time(WaitTimeStorage *storage, int wait_time)
+{
+    if (storage->streaming)
+    {
+        // Welford's update keeps the mean and variance numerically stable
+        storage->count++;
+        double delta = wait_time - storage->mean;
+        storage->mean += delta / storage->count;
+        storage->m2 += delta * (wait_time - storage->mean);
+        if (wait_time > storage->max) storage->max = wait_time;
+        storage->hist.counts[get_stream_bin(wait_time)]++;
+        storage->hist.total++;
+        return;
+    }
+
+    // 1. Check if the array is full
+    if (storage->count == storage->capacity)
+    {
+        // If full, double the capacity
+        long long new_capacity = storage->capacity * 2;
+        int *new_array = (int *)realloc(storage->wait_times, (size_t)new_capacity * sizeof(int));
+
+        if (new_array == NULL)
+        {
+            perror("Failed to re-allocate memory for wait time array");
+            // We can't add the new time, but the old data is still valid.
+            // In a real-world app, we'd handle this more gracefully.
+            return;
+        }
+
+        storage->wait_times = new_array;
+        storage->capacity = new_capacity;
+    }
+
+    // 2. Add the new wait time
+    storage->wait_times[storage->count] = wait_time;
+    storage->count++;
+}
+
+/**
+ * @brief Appends every wait time of src to the end of dest, in order. In
+ * streaming mode the accumulators are merged instead (Chan et al.'s
+ * pairwise update for mean and variance); both must use the same mode.
+ */
+void append_wait_times(WaitTimeStorage *dest, const WaitTimeStorage *src)
+{
+    if (dest->streaming)
+    {
+        long long n = dest->count + src->count;
+        if (n == 0) return;
+        double delta = src->mean - dest->mean;
+        dest->mean += delta * src->count / n;
+        dest->m2 += src->m2 + delta * delta * ((double)dest->count * src->count / n);
+        dest->count = n;
+        if (src->max > dest->max) dest->max = src->max;
+        for (int i = 0; i < STREAM_BINS; i++)
+        {
+            dest->hist.counts[i] += src->hist.counts[i];
+        }
+        dest->hist.total += src->hist.total;
+        return;
+    }
+
+    if (dest->count + src->count > dest->capacity)
+    {
+        long long new_capacity = dest->count + src->count;
+        int *new_array = (int *)realloc(dest->wait_times, (size_t)new_capacity * sizeof(int));
+        if (new_array == NULL)
+        {
+            perror("Failed to re-allocate memory for pooled wait time array");
+            exit(EXIT_FAILURE);
+        }
+        dest->wait_times = new_array;
+        dest->capacity = new_capacity;
+    }
+    memcpy(dest->wait_times + dest->count, src->wait_times, (size_t)src->count * sizeof(int));
+    dest->count += src->count;
+}
+
+/**
+ * @brief Frees the dynamic array and the storage struct itself.
+ */
+void free_storage(WaitTimeStorage *storage)
+{
+    free(storage->wait_times);
+    free(storage->hist.counts);
+    free(storage);
+}
+
+/*
+ * ============================================================================
+ * 4. SIMULATION & MATH FUNCTIONS
+ * ============================================================================
+ */
+
+/**
+ * @brief Rotates a 64-bit word left by k bits.
+ */
+uint64_t rotl64(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief Seeds a random number stream. The seed is expanded with SplitMix64
+ * so that similar seeds still give unrelated states.
+ */
+void rng_seed(Rng *rng, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        rng->s[i] = z ^ (z >> 31);
+    }
+}
+
+/**
+ * @brief Returns the next 64 random bits of a stream (xoshiro256**).
+ */
+uint64_t rng_next(Rng *rng)
+{
+    uint64_t *s = rng->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+
+    return result;
+}
+
+/**
+ * @brief Advances a stream by the distance encoded in a jump polynomial.
+ */
+void rng_apply_jump(Rng *rng, const uint64_t jump[4])
+{
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        for (int b = 0; b < 64; b++)
+        {
+            if (jump[i] & ((uint64_t)1 << b))
+            {
+                s0 ^= rng->s[0];
+                s1 ^= rng->s[1];
+                s2 ^= rng->s[2];
+                s3 ^= rng->s[3];
+            }
+            rng_next(rng);
+        }
+    }
+    rng->s[0] = s0;
+    rng->s[1] = s1;
+    rng->s[2] = s2;
+    rng->s[3] = s3;
+}
+
+/**
+ * @brief Advances a stream by 2^128 draws. Streams taken one jump apart can
+ * never overlap, since no run comes close to 2^128 draws.
+ */
+void rng_jump(Rng *rng)
+{
+    static const uint64_t JUMP[4] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                     0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+    rng_apply_jump(rng, JUMP);
+}
+
+/**
+ * @brief Advances a stream by 2^192 draws. Used to split one run's stream
+ * into substreams: stream r long-jumped sits at 2^192 + r * 2^128, clear of
+ * every stream create_streams hands out.
+ */
+void rng_long_jump(Rng *rng)
+{
+    static const uint64_t LONG_JUMP[4] = {0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+                                          0x77710069854ee241ULL, 0x39109bb02acbe635ULL};
+    rng_apply_jump(rng, LONG_JUMP);
+}
+
+/**
+ * @brief Creates `count` non-overlapping streams of one seed: stream r is
+ * the seeded state jumped r times.
+ * @return Array of streams; the caller must free() it.
+ */
+Rng *create_streams(uint64_t seed, int count)
+{
+    Rng *streams = (Rng *)malloc(count * sizeof(Rng));
+    if (streams == NULL)
+    {
+        perror("Failed to allocate memory for random number streams");
+        exit(EXIT_FAILURE);
+    }
+
+    Rng rng;
+    rng_seed(&rng, seed);
+    for (int r = 0; r < count; r++)
+    {
+        streams[r] = rng;
+        rng_jump(&rng);
+    }
+    return streams;
+}
+
+/**
+ * @brief Gets an unbiased random integer in [0, range) using Lemire's
+ * multiply-shift method; the retry loop only runs with probability
+ * range / 2^32, so for small ranges it almost never does.
+ */
+uint32_t rng_bounded(Rng *rng, uint32_t range)
+{
+    uint64_t m = (rng_next(rng) >> 32) * (uint64_t)range;
+    uint32_t low = (uint32_t)m;
+    if (low < range)
+    {
+        uint32_t threshold = -range % range;
+        while (low < threshold)
+        {
+            m = (rng_next(rng) >> 32) * (uint64_t)range;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+/**
+ * @brief Gets a random float in [0.0, 1.0) with 53 bits of precision.
+ */
+double rng_uniform(Rng *rng)
+{
+    return (double)(rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * @brief Seeds every lane from its own draw of `source`, expanded with
+ * SplitMix64 as rng_seed does. Lanes are not jump-separated like streams,
+ * but with a 2^256 period an overlap within any feasible run is negligible.
+ */
+void rng_lanes_seed(RngLanes *lanes, Rng *source)
+{
+    for (int lane = 0; lane < RNG_LANES; lane++)
+    {
+        Rng rng;
+        rng_seed(&rng, rng_next(source));
+        for (int i = 0; i < 4; i++)
+        {
+            lanes->s[i][lane] = rng.s[i];
+        }
+    }
+}
+
+/**
+ * @brief Fills out[0..n) with uniform integers below 2^bits (bits <= 32),
+ * taking the top bits of each lane's draw, so no range reduction and no
+ * bias. The inner loop over lanes is the xoshiro256** step written
+ * lane-wise, which GCC vectorizes at -O2 and above. It is kept rolled:
+ * at -O3 GCC would otherwise unroll it completely before the vectorizer
+ * sees it and leave it scalar.
+ * @param n A multiple of RNG_LANES.
+ */
+void rng_lanes_fill(RngLanes *lanes, uint32_t *out, long long n, int bits)
+{
+    uint64_t s0[RNG_LANES], s1[RNG_LANES], s2[RNG_LANES], s3[RNG_LANES];
+    memcpy(s0, lanes->s[0], sizeof(s0));
+    memcpy(s1, lanes->s[1], sizeof(s1));
+    memcpy(s2, lanes->s[2], sizeof(s2));
+    memcpy(s3, lanes->s[3], sizeof(s3));
+
+    int shift = 32 - bits;
+    for (long long i = 0; i < n; i += RNG_LANES)
+    {
+#pragma GCC unroll 1
+        for (int lane = 0; lane < RNG_LANES; lane++)
+        {
+            uint64_t result = rotl64(s1[lane] * 5, 7) * 9;
+            uint64_t t = s1[lane] << 17;
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = rotl64(s3[lane], 45);
+            out[i + lane] = (uint32_t)((result >> 32) >> shift);
+        }
+    }
+
+    memcpy(lanes->s[0], s0, sizeof(s0));
+    memcpy(lanes->s[1], s1, sizeof(s1));
+    memcpy(lanes->s[2], s2, sizeof(s2));
+    memcpy(lanes->s[3], s3, sizeof(s3));
+}
+
+/**
+ * @brief Sorts n keys below 2^bits ascending with an LSD radix sort on
+ * 8-bit digits, moving them back and forth between keys and scratch
+ * (or by insertion, in place, below RADIX_SORT_MIN_KEYS keys).
+ * @return Whichever of the two buffers ends up holding the sorted keys.
+ */
+uint32_t *radix_sort_keys(uint32_t *keys, uint32_t *scratch, long long n, int bits)
+{
+    if (n < RADIX_SORT_MIN_KEYS)
+    {
+        for (long long i = 1; i < n; i++)
+        {
+            uint32_t key = keys[i];
+            long long j = i;
+            while (j > 0 && keys[j - 1] > key)
+            {
+                keys[j] = keys[j - 1];
+                j--;
+            }
+            keys[j] = key;
+        }
+        return keys;
+    }
+    for (int shift = 0; shift < bits; shift += 8)
+    {
+        long long counts[256] = {0};
+        for (long long i = 0; i < n; i++)
+        {
+            counts[(keys[i] >> shift) & 0xFF]++;
+        }
+        long long offset = 0;
+        for (int digit = 0; digit < 256; digit++)
+        {
+            long long count = counts[digit];
+            counts[digit] = offset;
+            offset += count;
+        }
+        for (long long i = 0; i < n; i++)
+        {
+            scratch[counts[(keys[i] >> shift) & 0xFF]++] = keys[i];
+        }
+        uint32_t *sorted = scratch;
+        scratch = keys;
+        keys = sorted;
+    }
+    return keys;
+}
+
+/**
+ * @brief Generates a Poisson random number with Knuth's multiplication
+ * algorithm. Costs about lambda + 1 uniform draws, so it is only used for
+ * small lambda (exp(-lambda) also underflows to 0 above lambda ~ 745).
+ * @param lambda The average number of arrivals per minute.
+ */
+int get_poisson_knuth(Rng *rng, double lambda)
+{
+    // This algorithm is a standard, efficient way to generate
+    // Poisson-distributed random numbers.
+    double L = exp(-lambda);
+    double p = 1.0;
+    int k = 0;
+
+    do
+    {
+        k++;
+        // Get a random float between 0.0 and 1.0
+        double u = rng_uniform(rng);
+        p *= u;
+    } while (p > L);
+
+    return k - 1;
+}
+
+/**
+ * @brief Gets log(k!) without the data race of lgamma() on signgam. Exact
+ * table for small k, Stirling series (error < 1e-12) beyond.
+ */
+double get_log_factorial(int k)
+{
+    static const double table[10] = {
+        0.0, 0.0, 0.69314718055994531, 1.79175946922805500, 3.17805383034794562,
+        4.78749174278204599, 6.57925121201010100, 8.52516136106541430,
+        10.60460290274525023, 12.80182748008146961};
+    if (k < 10) return table[k];
+
+    double n = k + 1.0;
+    double inv = 1.0 / n;
+    double inv2 = inv * inv;
+    return (n - 0.5) * log(n) - n + 0.91893853320467274 +
+           inv * (1.0 / 12.0 - inv2 * (1.0 / 360.0 - inv2 / 1260.0));
+}
+
+/**
+ * @brief Generates a Poisson random number with Hormann's transformed
+ * rejection with squeeze (PTRS). Takes about 1.15 uniform pairs per draw
+ * whatever lambda is.
+ * @param lambda The mean; must be at least 10 for the constants to hold.
+ */
+int get_poisson_ptrs(Rng *rng, double lambda)
+{
+    double slam = sqrt(lambda);
+    double log_lambda = log(lambda);
+    double b = 0.931 + 2.53 * slam;
+    double a = -0.059 + 0.02483 * b;
+    double inv_alpha = 1.1239 + 1.1328 / (b - 3.4);
+    double v_r = 0.9277 - 3.6224 / (b - 2.0);
+
+    while (1)
+    {
+        double u = rng_uniform(rng) - 0.5;
+        double v = rng_uniform(rng);
+        double us = 0.5 - fabs(u);
+        double k = floor((2.0 * a / us + b) * u + lambda + 0.43);
+
+        // Fast acceptance inside the squeeze region
+        if (us >= 0.07 && v <= v_r)
+        {
+            return (int)k;
+        }
+        if (k < 0 || (us < 0.013 && v > us))
+        {
+            continue;
+        }
+        if (log(v) + log(inv_alpha) - log(a / (us * us) + b) <=
+            -lambda + k * log_lambda - get_log_factorial((int)k))
+        {
+            return (int)k;
+        }
+    }
+}
+
+/**
+ * @brief Generates a random number of customer arrivals for a given minute
+ * using the Poisson distribution: Knuth's algorithm for small lambda, PTRS
+ * from POISSON_PTRS_THRESHOLD up so the cost stays flat for any lambda.
+ * @param lambda The average number of arrivals per minute.
+ * @return The (random) number of customers (k) who arrived this minute.
+ */
+int get_poisson_random(Rng *rng, double lambda)
+{
+    if (lambda < POISSON_PTRS_THRESHOLD)
+    {
+        return get_poisson_knuth(rng, lambda);
+    }
+    return get_poisson_ptrs(rng, lambda);
+}
+
+/**
+ * @brief Gets a random float strictly between 0.0 and 1.0, safe to pass to log().
+ */
+double get_open_uniform(Rng *rng)
+{
+    return ((double)(rng_next(rng) >> 11) + 0.5) * 0x1.0p-53;
+}
+
+Ziggurat ziggurat; // Layer tables, built once by get_ziggurat
+pthread_once_t ziggurat_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Builds the layer tables (Marsaglia & Tsang, 2000, zigset).
+ */
+void build_ziggurat_tables(void)
+{
+    const double m1 = 2147483648.0, m2 = 4294967296.0;
+
+    double dn = 3.442619855899, tn = dn, vn = 9.91256303526217e-3;
+    double q = vn / exp(-0.5 * dn * dn);
+    ziggurat.normal_k[0] = (uint32_t)((dn / q) * m1);
+    ziggurat.normal_k[1] = 0;
+    ziggurat.normal_w[0] = q / m1;
+    ziggurat.normal_w[127] = dn / m1;
+    ziggurat.normal_f[0] = 1.0;
+    ziggurat.normal_f[127] = exp(-0.5 * dn * dn);
+    for (int i = 126; i >= 1; i--)
+    {
+        dn = sqrt(-2.0 * log(vn / dn + exp(-0.5 * dn * dn)));
+        ziggurat.normal_k[i + 1] = (uint32_t)((dn / tn) * m1);
+        tn = dn;
+        ziggurat.normal_f[i] = exp(-0.5 * dn * dn);
+        ziggurat.normal_w[i] = dn / m1;
+    }
+
+    double de = 7.697117470131487, te = de, ve = 3.949659822581572e-3;
+    q = ve / exp(-de);
+    ziggurat.exp_k[0] = (uint32_t)((de / q) * m2);
+    ziggurat.exp_k[1] = 0;
+    ziggurat.exp_w[0] = q / m2;
+    ziggurat.exp_w[255] = de / m2;
+    ziggurat.exp_f[0] = 1.0;
+    ziggurat.exp_f[255] = exp(-de);
+    for (int i = 254; i >= 1; i--)
+    {
+        de = -log(ve / de + exp(-de));
+        ziggurat.exp_k[i + 1] = (uint32_t)((de / te) * m2);
+        te = de;
+        ziggurat.exp_f[i] = exp(-de);
+        ziggurat.exp_w[i] = de / m2;
+    }
+}
+
+/**
+ * @brief Gets the shared ziggurat tables, building them on first use.
+ */
+const Ziggurat *get_ziggurat(void)
+{
+    pthread_once(&ziggurat_once, build_ziggurat_tables);
+    return &ziggurat;
+}
+
+/**
+ * @brief Draws a standard normal variate. The layer index comes from the
+ * low 7 bits and the signed abscissa from the high 32 bits of one draw, so
+ * the two are independent (the original SHR3 version reused bits).
+ */
+double get_normal_ziggurat(Rng *rng, const Ziggurat *zig)
+{
+    while (1)
+    {
+        uint64_t bits = rng_next(rng);
+        int layer = (int)(bits & 127);
+        int32_t h = (int32_t)(uint32_t)(bits >> 32);
+        uint32_t magnitude = (h < 0) ? (uint32_t)0 - (uint32_t)h : (uint32_t)h;
+        double x = h * zig->normal_w[layer];
+        if (magnitude < zig->normal_k[layer])
+        {
+            return x; // Inside the layer's rectangle: the common case
+        }
+        if (layer == 0)
+        {
+            // Base layer: sample the tail beyond r exactly (Marsaglia, 1964)
+            const double r = 3.442619855899;
+            double tail, y;
+            do
+            {
+                tail = -log(get_open_uniform(rng)) / r;
+                y = -log(get_open_uniform(rng));
+            } while (y + y < tail * tail);
+            return (h > 0) ? r + tail : -r - tail;
+        }
+        double f_low = zig->normal_f[layer], f_high = zig->normal_f[layer - 1];
+        if (f_low + rng_uniform(rng) * (f_high - f_low) < exp(-0.5 * x * x))
+        {
+            return x;
+        }
+    }
+}
+
+/**
+ * @brief Draws a standard exponential variate (mean 1); bits are split
+ * between layer and abscissa as in get_normal_ziggurat.
+ */
+double get_exponential_ziggurat(Rng *rng, const Ziggurat *zig)
+{
+    while (1)
+    {
+        uint64_t bits = rng_next(rng);
+        int layer = (int)(bits & 255);
+        uint32_t j = (uint32_t)(bits >> 32);
+        double x = j * zig->exp_w[layer];
+        if (j < zig->exp_k[layer])
+        {
+            return x;
+        }
+        if (layer == 0)
+        {
+            // Memoryless tail beyond the base layer
+            return 7.697117470131487 - log(get_open_uniform(rng));
+        }
+        double f_low = zig->exp_f[layer], f_high = zig->exp_f[layer - 1];
+        if (f_low + rng_uniform(rng) * (f_high - f_low) < exp(-x))
+        {
+            return x;
+        }
+    }
+}
+
+/**
+ * @brief Builds an alias table for n non-negative weights (Vose, 1991):
+ * columns below the average are paired with one above it until every
+ * column holds exactly 1/n of the probability.
+ */
+AliasTable *create_alias_table(const double *weights, int n)
+{
+    AliasTable *table = (AliasTable *)malloc(sizeof(AliasTable));
+    int *small = (int *)malloc(n * sizeof(int));
+    int *large = (int *)malloc(n * sizeof(int));
+    double *scaled = (double *)malloc(n * sizeof(double));
+    if (table == NULL || small == NULL || large == NULL || scaled == NULL)
+    {
+        perror("Failed to allocate memory for alias table");
+        exit(EXIT_FAILURE);
+    }
+    table->size = n;
+    table->prob = (double *)malloc(n * sizeof(double));
+    table->alias = (int *)malloc(n * sizeof(int));
+    if (table->prob == NULL || table->alias == NULL)
+    {
+        perror("Failed to allocate memory for alias table");
+        exit(EXIT_FAILURE);
+    }
+
+    double total = 0.0;
+    for (int i = 0; i < n; i++) total += weights[i];
+
+    int num_small = 0, num_large = 0;
+    for (int i = 0; i < n; i++)
+    {
+        scaled[i] = weights[i] * n / total;
+        if (scaled[i] < 1.0) small[num_small++] = i;
+        else large[num_large++] = i;
+    }
+    while (num_small > 0 && num_large > 0)
+    {
+        int less = small[--num_small];
+        int more = large[--num_large];
+        table->prob[less] = scaled[less];
+        table->alias[less] = more;
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0) small[num_small++] = more;
+        else large[num_large++] = more;
+    }
+    // Whatever is left is 1 up to rounding
+    while (num_large > 0)
+    {
+        int i = large[--num_large];
+        table->prob[i] = 1.0;
+        table->alias[i] = i;
+    }
+    while (num_small > 0)
+    {
+        int i = small[--num_small];
+        table->prob[i] = 1.0;
+        table->alias[i] = i;
+    }
+
+    free(scaled);
+    free(large);
+    free(small);
+    return table;
+}
+
+/**
+ * @brief Draws a column index from an alias table with one uniform: its
+ * integer part picks the column, its fraction decides column or alias.
+ */
+int draw_alias(Rng *rng, const AliasTable *table)
+{
+    double u = rng_uniform(rng) * table->size;
+    int column = (int)u;
+    return (u - column < table->prob[column]) ? column : table->alias[column];
+}
+
+/**
+ * @brief Frees an alias table.
+ */
+void free_alias_table(AliasTable *table)
+{
+    free(table->prob);
+    free(table->alias);
+    free(table);
+}
+
+/**
+ * @brief Draws a real-valued service time in minutes.
+ */
+double get_service_minutes(Rng *rng, const ServiceDistribution *service)
+{
+    switch (service->type)
+    {
+    case SERVICE_EXPONENTIAL:
+        return service->mean * get_exponential_ziggurat(rng, service->zig);
+    case SERVICE_LOGNORMAL:
+        return exp(service->mu + service->sigma * get_normal_ziggurat(rng, service->zig));
+    case SERVICE_EMPIRICAL:
+        return service->values[draw_alias(rng, service->alias)];
+    default:
+        return MIN_SERVICE_TIME + (MAX_SERVICE_TIME - MIN_SERVICE_TIME) * rng_uniform(rng);
+    }
+}
+
+/**
+ * @brief Gets a random service time for a customer, in whole minutes.
+ * The original uniform distribution draws an integer between
+ * MIN_SERVICE_TIME and MAX_SERVICE_TIME directly; other distributions are
+ * rounded to the nearest minute, at least 1 (a teller is busy for the
+ * minute service starts) and at most TELLER_CLOCK_MAX.
+ */
+int get_service_time(Rng *rng, const ServiceDistribution *service)
+{
+    if (service->type == SERVICE_UNIFORM)
+    {
+        return (int)rng_bounded(rng, MAX_SERVICE_TIME - MIN_SERVICE_TIME + 1) + MIN_SERVICE_TIME;
+    }
+    double minutes = get_service_minutes(rng, service);
+    if (minutes < 1.5) return 1;
+    if (minutes >= TELLER_CLOCK_MAX) return TELLER_CLOCK_MAX;
+    return (int)lround(minutes);
+}
+
+/**
+ * @brief Parses a --service value: "uniform", "exponential[:MEAN]",
+ * "lognormal[:MEAN,SD]" or "empirical:MINUTES=WEIGHT,MINUTES=WEIGHT,...".
+ * Means and standard deviations are in minutes; the defaults match the
+ * uniform distribution's mean of 2.5 minutes.
+ * @return 1 if the text is valid, 0 otherwise.
+ */
+int parse_service(const char *text, ServiceDistribution *service)
+{
+    char *end;
+    ServiceDistribution parsed;
+    memset(&parsed, 0, sizeof(parsed));
+
+    if (strcmp(text, "uniform") == 0)
+    {
+        *service = parsed;
+        return 1;
+    }
+    if (strncmp(text, "exponential", 11) == 0)
+    {
+        parsed.type = SERVICE_EXPONENTIAL;
+        parsed.mean = 0.5 * (MIN_SERVICE_TIME + MAX_SERVICE_TIME);
+        if (text[11] == ':')
+        {
+            parsed.mean = strtod(text + 12, &end);
+            if (*end != '\0') return 0;
+        }
+        else if (text[11] != '\0')
+        {
+            return 0;
+        }
+        if (!(parsed.mean > 0.0)) return 0;
+        parsed.zig = get_ziggurat();
+        *service = parsed;
+        return 1;
+    }
+    if (strncmp(text, "lognormal", 9) == 0)
+    {
+        double mean = 0.5 * (MIN_SERVICE_TIME + MAX_SERVICE_TIME), sd = 1.0;
+        if (text[9] == ':')
+        {
+            mean = strtod(text + 10, &end);
+            if (*end != ',') return 0;
+            sd = strtod(end + 1, &end);
+            if (*end != '\0') return 0;
+        }
+        else if (text[9] != '\0')
+        {
+            return 0;
+        }
+        if (!(mean > 0.0) || !(sd > 0.0)) return 0;
+        parsed.type = SERVICE_LOGNORMAL;
+        parsed.mean = mean;
+        parsed.sigma = sqrt(log1p((sd * sd) / (mean * mean)));
+        parsed.mu = log(mean) - 0.5 * parsed.sigma * parsed.sigma;
+        parsed.zig = get_ziggurat();
+        *service = parsed;
+        return 1;
+    }
+    if (strncmp(text, "empirical:", 10) == 0)
+    {
+        // One value=weight pair per comma
+        int n = 1;
+        for (const char *c = text + 10; *c != '\0'; c++) n += (*c == ',');
+        double *values = (double *)malloc(n * sizeof(double));
+        double *weights = (double *)malloc(n * sizeof(double));
+        if (values == NULL || weights == NULL)
+        {
+            perror("Failed to allocate memory for empirical service times");
+            exit(EXIT_FAILURE);
+        }
+        const char *cursor = text + 10;
+        double total = 0.0;
+        for (int i = 0; i < n; i++)
+        {
+            values[i] = strtod(cursor, &end);
+            if (*end != '=' || !(values[i] > 0.0)) break;
+            weights[i] = strtod(end + 1, &end);
+            if (!(weights[i] >= 0.0) || (*end != ',' && *end != '\0')) break;
+            total += weights[i];
+            cursor = end + 1;
+            if (i == n - 1 && *end == '\0' && total > 0.0)
+            {
+                parsed.type = SERVICE_EMPIRICAL;
+                parsed.values = values;
+                parsed.alias = create_alias_table(weights, n);
+                free(weights);
+                *service = parsed;
+                return 1;
+            }
+        }
+        free(values);
+        free(weights);
+        return 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief Builds an empirical service distribution from a file of recorded
+ * durations in minutes, one per line (the first field of a CSV row).
+ * Lines that do not start with a number after any blanks, such as headers
+ * and comments, are skipped; a number followed by anything but blanks, a
+ * comma or the end of the line ("1e3", "12abc") is an error. The file is
+ * memory-mapped and scanned once with a hand-rolled decimal reader (strtod
+ * needs a terminated string and honours the locale); durations are binned
+ * to 1/SERVICE_FILE_TICKS of a minute, so building the alias table costs
+ * O(file) + O(distinct durations) however many millions of rows there are.
+ * Durations below one bin or above TELLER_CLOCK_MAX minutes are moved to
+ * the nearest bin and counted, and the report shows how many.
+ */
+void load_service_file(const char *path, ServiceDistribution *service)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        perror("Failed to open service-time file");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t capacity = 1024;
+    long long *counts = (long long *)calloc(capacity, sizeof(long long));
+    if (counts == NULL)
+    {
+        perror("Failed to allocate memory for service-time histogram");
+        exit(EXIT_FAILURE);
+    }
+    const size_t max_tick = (size_t)TELLER_CLOCK_MAX * SERVICE_FILE_TICKS;
+    size_t highest = 0;
+    long long observations = 0, clamped = 0;
+
+    if (info.st_size > 0)
+    {
+        char *data = (char *)mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            perror("Failed to map service-time file");
+            exit(EXIT_FAILURE);
+        }
+        posix_madvise(data, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+
+        const char *p = data, *end = data + info.st_size;
+        long long line = 0;
+        while (p < end)
+        {
+            line++;
+            while (p < end && (*p == ' ' || *p == '\t')) p++;
+            int digit = p < end && (unsigned)(*p - '0') < 10;
+            int point = p + 1 < end && *p == '.' && (unsigned)(p[1] - '0') < 10;
+            if (digit || point)
+            {
+                uint64_t whole = 0, fraction = 0, scale = 1;
+                for (; p < end && (unsigned)(*p - '0') < 10; p++)
+                {
+                    // Saturate: anything this long is clamped below anyway
+                    if (whole < UINT32_MAX) whole = whole * 10 + (uint64_t)(*p - '0');
+                }
+                if (p < end && *p == '.')
+                {
+                    p++;
+                    // Digits past the 15th are below any bin width
+                    for (; p < end && (unsigned)(*p - '0') < 10; p++)
+                    {
+                        if (scale < 1000000000000000ULL)
+                        {
+                            fraction = fraction * 10 + (uint64_t)(*p - '0');
+                            scale *= 10;
+                        }
+                    }
+                }
+                while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+                if (p < end && *p != ',' && *p != '\n')
+                {
+                    printf("%s:%lld: malformed service time\n", path, line);
+                    exit(EXIT_FAILURE);
+                }
+                double minutes = (double)whole + (double)fraction / (double)scale;
+                size_t tick = (size_t)(minutes * SERVICE_FILE_TICKS + 0.5);
+                if (tick < 1 || tick > max_tick)
+                {
+                    tick = (tick < 1) ? 1 : max_tick;
+                    clamped++;
+                }
+                if (tick >= capacity)
+                {
+                    size_t grown = capacity;
+                    while (grown <= tick) grown *= 2;
+                    counts = (long long *)realloc(counts, grown * sizeof(long long));
+                    if (counts == NULL)
+                    {
+                        perror("Failed to grow service-time histogram");
+                        exit(EXIT_FAILURE);
+                    }
+                    memset(counts + capacity, 0, (grown - capacity) * sizeof(long long));
+                    capacity = grown;
+                }
+                counts[tick]++;
+                if (tick > highest) highest = tick;
+                observations++;
+            }
+            const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+            p = (newline != NULL) ? newline + 1 : end;
+        }
+        munmap(data, (size_t)info.st_size);
+    }
+    close(fd);
+
+    if (observations == 0)
+    {
+        printf("No service times found in %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    int distinct = 0;
+    for (size_t tick = 1; tick <= highest; tick++) distinct += (counts[tick] > 0);
+    double *values = (double *)malloc(distinct * sizeof(double));
+    double *weights = (double *)malloc(distinct * sizeof(double));
+    if (values == NULL || weights == NULL)
+    {
+        perror("Failed to allocate memory for empirical service times");
+        exit(EXIT_FAILURE);
+    }
+    int next = 0;
+    for (size_t tick = 1; tick <= highest; tick++)
+    {
+        if (counts[tick] > 0)
+        {
+            values[next] = (double)tick / SERVICE_FILE_TICKS;
+            weights[next] = (double)counts[tick];
+            next++;
+        }
+    }
+    free(counts);
+
+    ServiceDistribution parsed;
+    memset(&parsed, 0, sizeof(parsed));
+    parsed.type = SERVICE_EMPIRICAL;
+    parsed.values = values;
+    parsed.alias = create_alias_table(weights, distinct);
+    parsed.observations = observations;
+    parsed.clamped = clamped;
+    free(weights);
+    *service = parsed;
+}
+
+/**
+ * @brief Frees the tables of an empirical distribution and resets it to
+ * the uniform default.
+ */
+void free_service_distribution(ServiceDistribution *service)
+{
+    if (service->type == SERVICE_EMPIRICAL)
+    {
+        free(service->values);
+        free_alias_table(service->alias);
+    }
+    memset(service, 0, sizeof(*service));
+}
+
+/**
+ * @brief Describes a service distribution for the report header.
+ */
+void print_service(const ServiceDistribution *service)
+{
+    switch (service->type)
+    {
+    case SERVICE_EXPONENTIAL:
+        printf("exponential, mean %.2f minutes\n", service->mean);
+        break;
+    case SERVICE_LOGNORMAL:
+        printf("lognormal, mean %.2f minutes (mu %.3f, sigma %.3f)\n",
+               service->mean, service->mu, service->sigma);
+        break;
+    case SERVICE_EMPIRICAL:
+        if (service->observations > 0)
+        {
+            printf("empirical, %d distinct values from %lld recorded durations",
+                   service->alias->size, service->observations);
+            if (service->clamped > 0)
+            {
+                printf(" (%lld outside 1 s - %d min, clamped)", service->clamped, TELLER_CLOCK_MAX);
+            }
+            printf("\n");
+        }
+        else
+        {
+            printf("empirical, %d observed values\n", service->alias->size);
+        }
+        break;
+    default:
+        printf("uniform, %d-%d minutes\n", MIN_SERVICE_TIME, MAX_SERVICE_TIME);
+        break;
+    }
+}
+
+/**
+ * @brief Gets the number of minutes until the next minute with at least one
+ * arrival. With per-minute Poisson arrivals each minute is non-empty with
+ * probability 1 - exp(-lambda), so the gap is geometric.
+ * @param lambda The average number of arrivals per minute.
+ * @return A gap of at least 1 minute.
+ */
+int get_arrival_gap(Rng *rng, double lambda)
+{
+    // Inversion of the geometric CDF; log(P(no arrivals in a minute)) = -lambda
+    double gap = 1.0 + floor(log(get_open_uniform(rng)) / -lambda);
+    return (gap > INT_MAX) ? INT_MAX : (int)gap;
+}
+
+/**
+ * @brief Gets a Poisson random number conditioned on being at least 1, i.e.
+ * the size of an arrival batch in a minute known to be non-empty.
+ * @param lambda The average number of arrivals per minute.
+ */
+int get_poisson_positive(Rng *rng, double lambda)
+{
+    if (lambda >= 1.0)
+    {
+        // P(0) <= 0.37, so simple rejection needs few retries
+        int k;
+        do
+        {
+            k = get_poisson_random(rng, lambda);
+        } while (k == 0);
+        return k;
+    }
+
+    // Small lambda: invert the zero-truncated CDF starting from k = 1
+    double term = lambda * exp(-lambda) / -expm1(-lambda); // P(k = 1 | k >= 1)
+    double cdf = term;
+    double u = get_open_uniform(rng);
+    int k = 1;
+    while (u > cdf && term > 0.0)
+    {
+        k++;
+        term *= lambda / k;
+        cdf += term;
+    }
+    return k;
+}
+
+PoissonTable *poisson_tables = NULL; // Cache of built tables, newest first
+pthread_mutex_t poisson_tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Tabulates the CDF of Poisson(lambda) conditioned on X >= min_value
+ * over lambda +/- 12 standard deviations, and its guide table.
+ * @return The table, with size 0 if it would exceed POISSON_TABLE_MAX_SIZE.
+ */
+PoissonTable *build_poisson_table(double lambda, int min_value)
+{
+    PoissonTable *table = (PoissonTable *)calloc(1, sizeof(PoissonTable));
+    if (table == NULL)
+    {
+        perror("Failed to allocate memory for Poisson table");
+        exit(EXIT_FAILURE);
+    }
+    table->lambda = lambda;
+    table->min_value = min_value;
+
+    double spread = 12.0 * sqrt(lambda) + 10.0;
+    double lo = fmax((double)min_value, floor(lambda - spread));
+    double hi = ceil(lambda + spread);
+    if (hi - lo + 1.0 > POISSON_TABLE_MAX_SIZE)
+    {
+        return table;
+    }
+    table->lo = (int)lo;
+    table->size = (int)(hi - lo) + 1;
+    table->cdf = (double *)malloc(table->size * sizeof(double));
+    table->guide = (int *)malloc(table->size * sizeof(int));
+    if (table->cdf == NULL || table->guide == NULL)
+    {
+        perror("Failed to allocate memory for Poisson table");
+        exit(EXIT_FAILURE);
+    }
+
+    // Sum the pmf, then normalize: this applies the truncation and makes
+    // the last entry exactly 1 so a lookup can never run off the end
+    double total = 0.0;
+    for (int i = 0; i < table->size; i++)
+    {
+        int k = table->lo + i;
+        total += exp(k * log(lambda) - lambda - get_log_factorial(k));
+        table->cdf[i] = total;
+    }
+    for (int i = 0; i < table->size; i++)
+    {
+        table->cdf[i] /= total;
+    }
+    table->cdf[table->size - 1] = 1.0;
+
+    int i = 0;
+    for (int j = 0; j < table->size; j++)
+    {
+        while (table->cdf[i] < (double)j / table->size) i++;
+        table->guide[j] = i;
+    }
+    return table;
+}
+
+/**
+ * @brief Gets the shared table for (lambda, min_value), building it on
+ * first use. Sweep points and replications with the same lambda share one
+ * table; the cache is protected by a mutex so parallel runs can ask for it.
+ * @return The table, or NULL if lambda is too large to tabulate.
+ */
+const PoissonTable *get_poisson_table(double lambda, int min_value)
+{
+    pthread_mutex_lock(&poisson_tables_lock);
+    PoissonTable *table = poisson_tables;
+    while (table != NULL && (table->lambda != lambda || table->min_value != min_value))
+    {
+        table = table->next;
+    }
+    if (table == NULL)
+    {
+        table = build_poisson_table(lambda, min_value);
+        table->next = poisson_tables;
+        poisson_tables = table;
+    }
+    pthread_mutex_unlock(&poisson_tables_lock);
+    return (table->size > 0) ? table : NULL;
+}
+
+/**
+ * @brief Draws from a tabulated distribution by guided inversion.
+ */
+int draw_from_table(Rng *rng, const PoissonTable *table)
+{
+    double u = rng_uniform(rng);
+    int i = table->guide[(int)(u * table->size)];
+    while (table->cdf[i] <= u) i++;
+    return table->lo + i;
+}
+
+/**
+ * @brief Frees every cached Poisson table.
+ */
+void free_poisson_tables(void)
+{
+    while (poisson_tables != NULL)
+    {
+        PoissonTable *next = poisson_tables->next;
+        free(poisson_tables->cdf);
+        free(poisson_tables->guide);
+        free(poisson_tables);
+        poisson_tables = next;
+    }
+}
+
+/**
+ * @brief Draws the size of the next arrival batch.
+ */
+int get_batch_size(ArrivalSource *arrivals)
+{
+    if (arrivals->num_steps > 0)
+    {
+        const PoissonTable *table = arrivals->step_tables[arrivals->step];
+        if (table != NULL)
+        {
+            return draw_from_table(&arrivals->rng, table);
+        }
+        return get_poisson_positive(&arrivals->rng, arrivals->step_rates[arrivals->step]);
+    }
+    if (arrivals->batch_table != NULL)
+    {
+        return draw_from_table(&arrivals->rng, arrivals->batch_table);
+    }
+    return get_poisson_positive(&arrivals->rng, arrivals->lambda);
+}
+
+/**
+ * @brief Moves a profiled source on to the next step of its profile.
+ */
+void enter_next_step(ArrivalSource *arrivals)
+{
+    arrivals->step = (arrivals->step + 1 == arrivals->num_steps) ? 0 : arrivals->step + 1;
+    arrivals->step_end += arrivals->step_minutes;
+}
+
+/**
+ * @brief Gaps mode with a profile: finds the first minute after `minute`
+ * with arrivals. A minute at rate r is empty with probability exp(-r), so
+ * the next non-empty minute is the first at which the summed rates exceed
+ * one Exp(1) draw; within a step that is get_arrival_gap's geometric gap.
+ * If the gap runs past the step, the rate the step used up is subtracted
+ * and the remainder, again Exp(1) by memorylessness, carries into the next
+ * step. One draw per arrival, exact, and the current step is tracked
+ * incrementally so a gap needs no division.
+ */
+long long get_next_profile_minute(ArrivalSource *arrivals, long long minute)
+{
+    while (minute + 1 >= arrivals->step_end)
+    {
+        enter_next_step(arrivals);
+    }
+    double hazard = -log(get_open_uniform(&arrivals->rng));
+    while (1)
+    {
+        double rate = arrivals->step_rates[arrivals->step];
+        long long left = arrivals->step_end - 1 - minute; // Minutes of the step after `minute`
+        if (rate > 0.0)
+        {
+            double gap = 1.0 + floor(hazard / rate);
+            if (gap <= (double)left)
+            {
+                return minute + (long long)gap;
+            }
+            hazard = fmax(0.0, hazard - left * rate);
+        }
+        minute = arrivals->step_end - 1;
+        enter_next_step(arrivals);
+    }
+}
+
+/**
+ * @brief Continuous-time counterpart of get_next_profile_minute: the next
+ * arrival after time `after` (in minutes) is where the integrated rate
+ * first exceeds one Exp(1) draw, carried across step boundaries.
+ */
+double get_next_profile_time(Rng *rng, const SimConfig *config, double after)
+{
+    const ArrivalProfile *profile = &config->profile;
+    double hazard = -log(get_open_uniform(rng));
+    while (1)
+    {
+        long long step_index = (long long)floor(after / profile->step_minutes);
+        double step_end = (double)(step_index + 1) * profile->step_minutes;
+        double rate = config->lambda * profile->factors[step_index % profile->num_steps];
+        if (rate > 0.0)
+        {
+            double next = after + hazard / rate;
+            if (next < step_end)
+            {
+                return next;
+            }
+            hazard = fmax(0.0, hazard - (step_end - after) * rate);
+        }
+        after = step_end;
+    }
+}
+
+/**
+ * @brief Sorted mode: makes room for `slots` minutes in window and scratch.
+ */
+void reserve_arrival_window(ArrivalSource *arrivals, long long slots)
+{
+    if (slots > arrivals->window_capacity)
+    {
+        free(arrivals->window);
+        free(arrivals->scratch);
+        arrivals->window = (uint32_t *)malloc(slots * sizeof(uint32_t));
+        arrivals->scratch = (uint32_t *)malloc(slots * sizeof(uint32_t));
+        if (arrivals->window == NULL || arrivals->scratch == NULL)
+        {
+            perror("Failed to allocate memory for arrival window");
+            exit(EXIT_FAILURE);
+        }
+        arrivals->window_capacity = slots;
+    }
+}
+
+/**
+ * @brief Sorted mode: sorts the window's first n minutes, all below 2^bits,
+ * and makes it the window handed out.
+ */
+void sort_arrival_window(ArrivalSource *arrivals, long long n, int bits)
+{
+    uint32_t *sorted = radix_sort_keys(arrivals->window, arrivals->scratch, n, bits);
+    if (sorted != arrivals->window)
+    {
+        arrivals->scratch = arrivals->window;
+        arrivals->window = sorted;
+    }
+    arrivals->window_size = n;
+    arrivals->window_pos = 0;
+}
+
+/**
+ * @brief Sorted mode with a profile: generates the next non-empty window.
+ * Windows stop at step boundaries, so each has a single rate and is drawn
+ * exactly like a constant-rate window: the Poisson total, then uniform
+ * minutes below the window's length (by rejection from the next power of
+ * two, which keeps at least half) and the sort. No draw is thinned away,
+ * and steps with rate 0 are skipped whole.
+ */
+void fill_profile_window(ArrivalSource *arrivals)
+{
+    long long max_length = 1LL << arrivals->window_bits;
+    long long n = 0, length = 0;
+    while (n == 0)
+    {
+        arrivals->window_start += arrivals->window_length;
+        if (arrivals->window_start == arrivals->step_end)
+        {
+            enter_next_step(arrivals);
+        }
+        double rate = arrivals->step_rates[arrivals->step];
+        length = arrivals->step_end - arrivals->window_start;
+        if (rate > 0.0)
+        {
+            if (length > max_length) length = max_length;
+            n = get_poisson_random(&arrivals->rng, rate * length);
+        }
+        arrivals->window_length = length;
+    }
+
+    int bits = 0;
+    while ((1LL << bits) < length) bits++;
+    // Each round draws enough for the minutes still missing and appends the
+    // ones below length, so the window never holds more than n + RNG_LANES
+    reserve_arrival_window(arrivals, (n + RNG_LANES - 1) / RNG_LANES * RNG_LANES + RNG_LANES);
+    long long have = 0;
+    while (have < n)
+    {
+        long long slots = (n - have + RNG_LANES - 1) / RNG_LANES * RNG_LANES;
+        rng_lanes_fill(arrivals->lanes, arrivals->scratch, slots, bits);
+        for (long long i = 0; i < slots; i++)
+        {
+            arrivals->window[have] = arrivals->scratch[i];
+            have += (arrivals->scratch[i] < (uint32_t)length);
+        }
+    }
+    sort_arrival_window(arrivals, n, bits);
+}
+
+/**
+ * @brief Sorted mode: generates the next non-empty window. Given the
+ * window's Poisson(lambda * 2^bits) total, the arrival minutes are
+ * independent and uniform over the window, so they are drawn in bulk from
+ * the lanes and radix-sorted instead of walking minute by minute.
+ */
+void fill_arrival_window(ArrivalSource *arrivals)
+{
+    if (arrivals->num_steps > 0)
+    {
+        fill_profile_window(arrivals);
+        return;
+    }
+
+    long long window_minutes = 1LL << arrivals->window_bits;
+    long long n;
+    do
+    {
+        arrivals->window_start += window_minutes;
+        n = get_poisson_random(&arrivals->rng, arrivals->lambda * window_minutes);
+    } while (n == 0);
+
+    long long slots = (n + RNG_LANES - 1) / RNG_LANES * RNG_LANES;
+    reserve_arrival_window(arrivals, slots);
+    rng_lanes_fill(arrivals->lanes, arrivals->window, slots, arrivals->window_bits);
+    sort_arrival_window(arrivals, n, arrivals->window_bits);
+}
+
+/**
+ * @brief Sorted mode: hands out the next run of equal minutes as a batch.
+ */
+void next_sorted_batch(ArrivalSource *arrivals)
+{
+    if (arrivals->window_pos == arrivals->window_size)
+    {
+        fill_arrival_window(arrivals);
+    }
+    const uint32_t *window = arrivals->window;
+    long long first = arrivals->window_pos;
+    long long end = first + 1;
+    while (end < arrivals->window_size && window[end] == window[first]) end++;
+
+    arrivals->minute = arrivals->window_start + window[first];
+    arrivals->count = (int)(end - first);
+    arrivals->window_pos = end;
+}
+
+/**
+ * @brief Reads the run of decimal digits at p, eight bytes at a time on
+ * little-endian machines: one unaligned load, a few masks and a count of
+ * trailing zero bits find how many of the eight are digits, and three
+ * multiplies convert them (SWAR), instead of a multiply and a branch per
+ * character. Other machines use the plain digit loop. Only the first 19
+ * digits are meaningful.
+ * @param digits Receives the number of digits read.
+ * @return The first byte after the digits.
+ */
+const char *parse_digits_swar(const char *p, const char *end, uint64_t *value, int *digits)
+{
+    static const uint64_t powers[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    uint64_t result = 0;
+    int count = 0;
+    while (HOST_LITTLE_ENDIAN && end - p >= 8)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, p, 8);
+        // A byte is a digit iff its high nibble is 3 and adding 6 keeps it 3
+        uint64_t nondigit = ((chunk & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL) |
+                            ((((chunk & 0x7F7F7F7F7F7F7F7FULL) + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) ^
+                             0x3030303030303030ULL);
+        int k = (nondigit == 0) ? 8 : __builtin_ctzll(nondigit) / 8;
+        if (k == 0)
+        {
+            break;
+        }
+        // Shift the k digits to the top so the missing ones read as leading zeros
+        uint64_t d = (chunk - 0x3030303030303030ULL) << (8 * (8 - k));
+        d = ((d & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+        d = ((d & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+        d = ((d & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+        result = result * powers[k] + d;
+        count += k;
+        p += k;
+        if (k < 8)
+        {
+            *value = result;
+            *digits = count;
+            return p;
+        }
+    }
+    // Fewer than 8 bytes left in the buffer (or a big-endian machine)
+    while (p < end && (unsigned)(*p - '0') < 10)
+    {
+        result = result * 10 + (uint64_t)(*p++ - '0');
+        count++;
+    }
+    *value = result;
+    *digits = count;
+    return p;
+}
+
+/**
+ * @brief Reads the next timestamp of a trace, in seconds. Text lines that
+ * do not start with a digit after any blanks are skipped as headers or
+ * comments; a number followed by anything but blanks, a comma or the end
+ * of the line ("1.7e9", "2023-01-01 09:00") stops the replay with the
+ * trace's path and line number.
+ * @return 1 if a record was read, 0 at the end of the log.
+ */
+int read_trace_seconds(TraceCursor *cursor, double *seconds)
+{
+    const ArrivalTrace *trace = cursor->trace;
+    const char *end = trace->data + trace->size;
+    const char *p = trace->data + cursor->offset;
+    double value;
+
+    if (trace->binary)
+    {
+        if (end - p < 8)
+        {
+            return 0;
+        }
+        uint64_t bits;
+        memcpy(&bits, p, 8);
+        if (!HOST_LITTLE_ENDIAN)
+        {
+            // Binary traces are little-endian whatever machine wrote them
+            bits = __builtin_bswap64(bits);
+        }
+        memcpy(&value, &bits, 8);
+        p += 8;
+    }
+    else
+    {
+        // Skip headers, comments and blank lines
+        while (p < end)
+        {
+            while (p < end && (*p == ' ' || *p == '\t')) p++;
+            if (p < end && (unsigned)(*p - '0') < 10) break;
+            const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+            p = (newline != NULL) ? newline + 1 : end;
+            if (cursor->line >= 0) cursor->line++;
+        }
+        if (p == end)
+        {
+            cursor->offset = trace->size;
+            return 0;
+        }
+        static const uint64_t scales[10] = {1, 10, 100, 1000, 10000, 100000, 1000000,
+                                            10000000, 100000000, 1000000000};
+        uint64_t whole, fraction = 0;
+        int digits, fraction_digits = 0;
+        p = parse_digits_swar(p, end, &whole, &digits);
+        if (p < end && *p == '.')
+        {
+            // Nanoseconds are as fine as a double keeps next to epoch seconds
+            const char *limit = (end - (p + 1) > 9) ? p + 10 : end;
+            p = parse_digits_swar(p + 1, limit, &fraction, &fraction_digits);
+            while (p < end && (unsigned)(*p - '0') < 10) p++;
+        }
+        uint64_t scale = scales[fraction_digits];
+        if (whole < (1ULL << 53) / scale)
+        {
+            // Both integers are exact doubles, so one division rounds correctly, as strtod does
+            value = (double)(whole * scale + fraction) / (double)scale;
+        }
+        else
+        {
+            value = (double)whole + (double)fraction / (double)scale;
+        }
+        if (p < end && *p == '\n')
+        {
+            // The usual bare timestamp per line
+            p++;
+        }
+        else
+        {
+            // Otherwise the timestamp must end its line or its CSV field
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+            if (p < end && *p != ',' && *p != '\n')
+            {
+                if (cursor->line >= 0)
+                {
+                    printf("%s:%lld: malformed timestamp\n", trace->path, cursor->line + 1);
+                }
+                else
+                {
+                    printf("%s: malformed timestamp in the last record\n", trace->path);
+                }
+                exit(EXIT_FAILURE);
+            }
+            const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+            p = (newline != NULL) ? newline + 1 : end;
+        }
+        if (cursor->line >= 0) cursor->line++;
+    }
+
+    if (value < cursor->last)
+    {
+        printf("Trace %s is not in time order (%.3f after %.3f)\n", trace->path, value, cursor->last);
+        exit(EXIT_FAILURE);
+    }
+    cursor->last = value;
+    cursor->offset = (size_t)(p - trace->data);
+    *seconds = value;
+    return 1;
+}
+
+/**
+ * @brief Starts reading a trace from its first record.
+ */
+void open_trace_cursor(TraceCursor *cursor, const ArrivalTrace *trace)
+{
+    cursor->trace = trace;
+    cursor->offset = trace->binary ? 8 : 0;
+    cursor->last = -HUGE_VAL;
+    cursor->line = 0;
+}
+
+/**
+ * @brief Converts a trace timestamp to the minute of the replayed day.
+ */
+long long get_trace_minute(const ArrivalTrace *trace, double seconds)
+{
+    return (long long)floor((seconds - trace->origin) / 60.0);
+}
+
+/**
+ * @brief Finds the last timestamp of a trace without reading the rest:
+ * the last record of a binary log, or the last line of a text log that
+ * starts with a digit after any blanks, found by walking back from the end.
+ */
+double get_last_trace_seconds(const ArrivalTrace *trace)
+{
+    TraceCursor cursor;
+    open_trace_cursor(&cursor, trace);
+    double seconds = 0.0;
+    if (trace->binary)
+    {
+        cursor.offset = trace->size - 8;
+        read_trace_seconds(&cursor, &seconds);
+        return seconds;
+    }
+    // Counting the lines before the last one would mean reading them all
+    cursor.line = -1;
+    size_t line_end = trace->size;
+    while (line_end > 0)
+    {
+        size_t line_start = line_end - 1;
+        while (line_start > 0 && trace->data[line_start - 1] != '\n') line_start--;
+        size_t first = line_start;
+        while (first < line_end && (trace->data[first] == ' ' || trace->data[first] == '\t')) first++;
+        if (first < line_end && (unsigned)(trace->data[first] - '0') < 10)
+        {
+            cursor.offset = line_start;
+            read_trace_seconds(&cursor, &seconds);
+            return seconds;
+        }
+        line_end = line_start;
+    }
+    return seconds;
+}
+
+/**
+ * @brief Memory-maps an arrival log for replay. Nothing is parsed up
+ * front: the first and last records fix the origin and span, and runs
+ * then stream the records through their own cursors, so a log of any size
+ * costs no memory beyond the page cache. Release it with close_arrival_trace.
+ */
+ArrivalTrace *open_arrival_trace(const char *path)
+{
+    ArrivalTrace *trace = (ArrivalTrace *)calloc(1, sizeof(ArrivalTrace));
+    if (trace == NULL)
+    {
+        perror("Failed to allocate memory for arrival trace");
+        exit(EXIT_FAILURE);
+    }
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        perror("Failed to open arrival trace");
+        exit(EXIT_FAILURE);
+    }
+    if (info.st_size == 0)
+    {
+        printf("No arrivals found in %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    trace->path = path;
+    trace->size = (size_t)info.st_size;
+    trace->data = (const char *)mmap(NULL, trace->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (trace->data == MAP_FAILED)
+    {
+        perror("Failed to map arrival trace");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+    posix_madvise((void *)trace->data, trace->size, POSIX_MADV_SEQUENTIAL);
+
+    trace->binary = trace->size >= 8 && memcmp(trace->data, TRACE_MAGIC, 8) == 0;
+    if (trace->binary && (trace->size - 8) % 8 != 0)
+    {
+        printf("Binary trace %s does not hold whole 8-byte records\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    TraceCursor cursor;
+    double first, last;
+    open_trace_cursor(&cursor, trace);
+    if (!read_trace_seconds(&cursor, &first))
+    {
+        printf("No arrivals found in %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    last = get_last_trace_seconds(trace);
+    if (last < first)
+    {
+        printf("Trace %s is not in time order (%.3f after %.3f)\n", path, last, first);
+        exit(EXIT_FAILURE);
+    }
+    trace->origin = floor(first / 60.0) * 60.0;
+    trace->span_minutes = get_trace_minute(trace, last) + 1;
+    return trace;
+}
+
+/**
+ * @brief Unmaps and frees an arrival trace.
+ */
+void close_arrival_trace(ArrivalTrace *trace)
+{
+    munmap((void *)trace->data, trace->size);
+    free(trace);
+}
+
+/**
+ * @brief Trace mode: hands out the next minute of the log and how many of
+ * its records fall in it.
+ */
+void next_trace_batch(ArrivalSource *arrivals)
+{
+    arrivals->minute = arrivals->pending_minute;
+    arrivals->count = 0;
+    if (arrivals->minute == LLONG_MAX)
+    {
+        return;
+    }
+    do
+    {
+        double seconds;
+        arrivals->count++;
+        arrivals->pending_minute = read_trace_seconds(&arrivals->cursor, &seconds)
+                                       ? get_trace_minute(arrivals->cursor.trace, seconds)
+                                       : LLONG_MAX;
+    } while (arrivals->pending_minute == arrivals->minute);
+}
+
+/**
+ * @brief Sets up a source's profile: per-step rates, the step in force at
+ * `origin`, and in gaps mode each step's batch-size table. In sorted mode
+ * lambda becomes the peak rate, which sizes the windows.
+ */
+void open_arrival_profile(ArrivalSource *arrivals, const ArrivalProfile *profile, long long origin)
+{
+    int num_steps = profile->num_steps;
+    arrivals->num_steps = num_steps;
+    arrivals->step_minutes = profile->step_minutes;
+    arrivals->origin = origin;
+    long long step_index = origin / profile->step_minutes;
+    arrivals->step = (int)(step_index % num_steps);
+    arrivals->step_end = (step_index + 1) * profile->step_minutes - origin;
+    arrivals->step_rates = (double *)malloc(num_steps * sizeof(double));
+    if (arrivals->step_rates == NULL)
+    {
+        perror("Failed to allocate memory for arrival profile");
+        exit(EXIT_FAILURE);
+    }
+    double peak = 0.0;
+    for (int i = 0; i < num_steps; i++)
+    {
+        arrivals->step_rates[i] = arrivals->lambda * profile->factors[i];
+        if (arrivals->step_rates[i] > peak) peak = arrivals->step_rates[i];
+    }
+
+    if (arrivals->mode == ARRIVALS_SORTED)
+    {
+        arrivals->lambda = peak;
+        return;
+    }
+
+    arrivals->step_tables = (const PoissonTable **)malloc(num_steps * sizeof(PoissonTable *));
+    if (arrivals->step_tables == NULL)
+    {
+        perror("Failed to allocate memory for arrival profile");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < num_steps; i++)
+    {
+        double rate = arrivals->step_rates[i];
+        arrivals->step_tables[i] = (rate > 0.0) ? get_poisson_table(rate, 1) : NULL;
+    }
+}
+
+/**
+ * @brief Starts arrivals for a stretch of the day beginning at minute
+ * `origin`. The source copies `stream` and long-jumps the copy, so the
+ * caller keeps drawing service times from `stream` itself; it counts
+ * minutes from 0 but reads the profile from `origin` on. Release it with
+ * close_arrivals.
+ */
+void open_arrivals_from(ArrivalSource *arrivals, const Rng *stream, const SimConfig *config, long long origin)
+{
+    memset(arrivals, 0, sizeof(*arrivals));
+    arrivals->rng = *stream;
+    rng_long_jump(&arrivals->rng);
+    arrivals->lambda = config->lambda;
+    arrivals->mode = config->arrival_mode;
+
+    if (config->trace != NULL)
+    {
+        // A replayed day starts at the log's first minute; origin is unused
+        double seconds;
+        arrivals->mode = ARRIVALS_TRACE;
+        open_trace_cursor(&arrivals->cursor, config->trace);
+        arrivals->pending_minute = read_trace_seconds(&arrivals->cursor, &seconds)
+                                       ? get_trace_minute(config->trace, seconds)
+                                       : LLONG_MAX;
+        next_trace_batch(arrivals);
+        return;
+    }
+
+    if (config->profile.num_steps > 0)
+    {
+        open_arrival_profile(arrivals, &config->profile, origin);
+    }
+
+    if (arrivals->mode == ARRIVALS_SORTED)
+    {
+        arrivals->lanes = (RngLanes *)malloc(sizeof(RngLanes));
+        if (arrivals->lanes == NULL)
+        {
+            perror("Failed to allocate memory for arrival generator");
+            exit(EXIT_FAILURE);
+        }
+        rng_lanes_seed(arrivals->lanes, &arrivals->rng);
+
+        // Grow the window while it stays within the expected-arrival target
+        // and short of covering the whole horizon
+        int bits = 0;
+        while (bits < ARRIVAL_WINDOW_MAX_BITS && arrivals->lambda * (2LL << bits) <= ARRIVAL_WINDOW_TARGET &&
+               (1LL << bits) < config->sim_minutes)
+        {
+            bits++;
+        }
+        arrivals->window_bits = bits;
+        // Profile windows advance by their own length, from 0
+        arrivals->window_start = (arrivals->num_steps > 0) ? 0 : -(1LL << bits);
+        next_sorted_batch(arrivals);
+        return;
+    }
+
+    // The first gap counts from minute -1, so minute 0 can have arrivals
+    if (arrivals->num_steps > 0)
+    {
+        arrivals->minute = get_next_profile_minute(arrivals, -1);
+    }
+    else
+    {
+        arrivals->batch_table = get_poisson_table(config->lambda, 1);
+        arrivals->minute = get_arrival_gap(&arrivals->rng, config->lambda) - 1;
+    }
+    arrivals->count = get_batch_size(arrivals);
+}
+
+/**
+ * @brief Starts a day's arrivals (open_arrivals_from at minute 0).
+ */
+void open_arrivals(ArrivalSource *arrivals, const Rng *stream, const SimConfig *config)
+{
+    open_arrivals_from(arrivals, stream, config, 0);
+}
+
+/**
+ * @brief Moves on to the next minute with arrivals.
+ */
+void advance_arrivals(ArrivalSource *arrivals)
+{
+    if (arrivals->mode == ARRIVALS_TRACE)
+    {
+        next_trace_batch(arrivals);
+        return;
+    }
+    if (arrivals->mode == ARRIVALS_SORTED)
+    {
+        next_sorted_batch(arrivals);
+        return;
+    }
+    if (arrivals->num_steps > 0)
+    {
+        arrivals->minute = get_next_profile_minute(arrivals, arrivals->minute);
+    }
+    else
+    {
+        arrivals->minute += get_arrival_gap(&arrivals->rng, arrivals->lambda);
+    }
+    arrivals->count = get_batch_size(arrivals);
+}
+
+/**
+ * @brief Frees the buffers of a sorted-mode or profiled source.
+ */
+void close_arrivals(ArrivalSource *arrivals)
+{
+    free(arrivals->lanes);
+    free(arrivals->window);
+    free(arrivals->scratch);
+    free(arrivals->step_rates);
+    free(arrivals->step_tables);
+}
+
+/*
+ * ============================================================================
+ * 5. DATA ANALYSIS FUNCTIONS
+ * ============================================================================
+ */
+
+/**
+ * @brief A comparison function required by qsort() to sort integers.
+ */
+int compare_int(const void *a, const void *b)
+{
+    return (*(int *)a - *(int *)b);
+}
+
+/**
+ * @brief Calculates the mean (average) of the wait times.
+ */
+double get_mean(int *data, long long n)
+{
+    if (n == 0) return 0.0;
+    long long sum = 0; // Use long long to prevent overflow
+    for (long long i = 0; i < n; i++)
+    {
+        sum += data[i];
+    }
+    return (double)sum / n;
+}
+
+/**
+ * @brief Calculates the median (middle value) of the wait times.
+ * @note This function ASSUMES the data array has already been sorted.
+ */
+double get_median(int *sorted_data, long long n)
+{
+    if (n == 0) return 0.0;
+    
+    if (n % 2 == 0)
+    {
+        // Even number of elements: average the two middle ones
+        int mid1 = sorted_data[n / 2 - 1];
+        int mid2 = sorted_data[n / 2];
+        return (double)(mid1 + mid2) / 2.0;
+    }
+    else
+    {
+        // Odd number of elements: return the middle one
+        return (double)sorted_data[n / 2];
+    }
+}
+
+/**
+ * @brief Calculates the mode (most frequent value) of the wait times.
+ * Uses a frequency array for efficiency.
+ */
+int get_mode(int *data, long long n)
+{
+    if (n == 0) return 0;
+
+    // We need to find the max wait time to size our frequency array.
+    // (We could also just use the max possible sim time)
+    int max_val = 0;
+    for (long long i = 0; i < n; i++) {
+        if (data[i] > max_val) max_val = data[i];
+    }
+
+    // What if the max wait time is 0 (e.g., no customers)?
+    // We still need an array of at least size 1.
+    int freq_array_size = (max_val < 1) ? 1 : max_val + 1;
+
+    // Allocate a frequency array and initialize to zero
+    // calloc is perfect for this, as it zeroes the memory.
+    long long *frequency = (long long *)calloc(freq_array_size, sizeof(long long));
+    if (frequency == NULL) {
+        perror("Failed to allocate memory for mode calculation");
+        return -1; // Error
+    }
+
+    // Populate the frequency array
+    for (long long i = 0; i < n; i++)
+    {
+        frequency[data[i]]++;
+    }
+
+    // Find the index (value) with the highest frequency
+    int mode = 0;
+    long long max_freq = 0;
+    for (int i = 0; i < freq_array_size; i++)
+    {
+        if (frequency[i] > max_freq)
+        {
+            max_freq = frequency[i];
+            mode = i;
+        }
+    }
+
+    free(frequency); // Clean up the frequency array
+    return mode;
+}
+
+/**
+ * @brief Calculates the standard deviation of the wait times.
+ */
+double get_std_dev(int *data, long long n, double mean)
+{
+    if (n == 0) return 0.0;
+    
+    double sum_sq_diff = 0.0;
+    for (long long i = 0; i < n; i++)
+    {
+        sum_sq_diff += pow(data[i] - mean, 2);
+    }
+    return sqrt(sum_sq_diff / n);
+}
+
+/**
+ * @brief Gets the p-th percentile (0-100) of the wait times using the
+ * nearest-rank method.
+ * @note This function ASSUMES the data array has already been sorted.
+ */
+int get_percentile(int *sorted_data, long long n, double p)
+{
+    if (n == 0) return 0;
+    long long rank = (long long)ceil(p / 100.0 * n);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted_data[rank - 1];
+}
+
+/**
+ * @brief Finds the single longest wait time.
+ * @note This function ASSUMES the data array has already been sorted.
+ */
+int get_max_wait(int *sorted_data, long long n)
+{
+    if (n == 0) return 0;
+    return sorted_data[n - 1]; // The last element of the sorted array
+}
+
+/**
+ * @brief Gets the two-sided 95% critical value of Student's t distribution.
+ * @param df Degrees of freedom (number of replications - 1).
+ */
+double get_t_critical(int df)
+{
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df < 1) return 0.0;
+    if (df <= 30) return table[df - 1];
+
+    // Beyond the table, correct the normal quantile for the heavier tails
+    const double z = 1.959964;
+    return z + (z * z * z + z) / (4.0 * df);
+}
+
+/**
+ * @brief Prints "mean +/- half-width" of a per-replication quantity, where
+ * the half-width is the 95% confidence interval of the mean over days.
+ */
+void print_interval(const char *label, const double *values, int n, const char *unit)
+{
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += values[i];
+    }
+    double mean = sum / n;
+
+    double sum_sq_diff = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        sum_sq_diff += (values[i] - mean) * (values[i] - mean);
+    }
+    double half_width = (n > 1) ? get_t_critical(n - 1) * sqrt(sum_sq_diff / (n - 1)) / sqrt(n) : 0.0;
+
+    printf("%-21s%.2f +/- %.2f %s\n", label, mean, half_width, unit);
+}
+
+/**
+ * @brief Builds a counting histogram of the wait times in O(n + range),
+ * without sorting or modifying the data.
+ */
+void build_histogram(WaitHistogram *hist, const int *data, long long n)
+{
+    int max_val = 0;
+    for (long long i = 0; i < n; i++)
+    {
+        if (data[i] > max_val) max_val = data[i];
+    }
+
+    hist->size = max_val + 1;
+    hist->exact_limit = hist->size;
+    hist->total = n;
+    hist->counts = (long long *)calloc(hist->size, sizeof(long long));
+    if (hist->counts == NULL)
+    {
+        perror("Failed to allocate memory for wait-time histogram");
+        exit(EXIT_FAILURE);
+    }
+    for (long long i = 0; i < n; i++)
+    {
+        hist->counts[data[i]]++;
+    }
+}
+
+/**
+ * @brief Frees the bins of a histogram.
+ */
+void free_histogram(WaitHistogram *hist)
+{
+    free(hist->counts);
+    hist->counts = NULL;
+}
+
+/**
+ * @brief Gets the wait value a bin stands for: the value itself for exact
+ * bins, the midpoint of the bin's range for log-linear ones.
+ */
+int get_bin_value(const WaitHistogram *hist, int bin)
+{
+    if (bin < hist->exact_limit) return bin;
+    int offset = bin - hist->exact_limit;
+    int shift = STREAM_EXACT_BITS + offset / STREAM_SUB_BINS - STREAM_SUB_BITS;
+    int low = (STREAM_SUB_BINS + offset % STREAM_SUB_BINS) << shift;
+    return low + ((1 << shift) >> 1);
+}
+
+/**
+ * @brief Gets how many wait values a bin covers (1 for exact bins).
+ */
+int get_bin_width(const WaitHistogram *hist, int bin)
+{
+    if (bin < hist->exact_limit) return 1;
+    return 1 << (STREAM_EXACT_BITS + (bin - hist->exact_limit) / STREAM_SUB_BINS - STREAM_SUB_BITS);
+}
+
+/**
+ * @brief Gets the value of the k-th smallest wait (1-based) from the counts.
+ */
+int get_histogram_rank(const WaitHistogram *hist, long long k)
+{
+    long long seen = 0;
+    for (int w = 0; w < hist->size; w++)
+    {
+        seen += hist->counts[w];
+        if (seen >= k) return get_bin_value(hist, w);
+    }
+    return get_bin_value(hist, hist->size - 1);
+}
+
+/**
+ * @brief Gets the p-th percentile (0-100) using the nearest-rank method,
+ * matching get_percentile on sorted data.
+ */
+int get_histogram_percentile(const WaitHistogram *hist, double p)
+{
+    if (hist->total == 0) return 0;
+    long long rank = (long long)ceil(p / 100.0 * hist->total);
+    if (rank < 1) rank = 1;
+    if (rank > hist->total) rank = hist->total;
+    return get_histogram_rank(hist, rank);
+}
+
+/**
+ * @brief Computes every report statistic from a histogram in O(range).
+ * For an exact histogram the results match the sort-based functions above.
+ */
+void summarize_histogram(const WaitHistogram *hist, WaitSummary *summary)
+{
+    long long n = hist->total;
+    summary->count = n;
+    if (n == 0)
+    {
+        summary->mean = summary->median = summary->std_dev = 0.0;
+        summary->mode = summary->p95 = summary->max = 0;
+        return;
+    }
+
+    long long sum = 0;
+    long long max_freq = 0;
+    int max_freq_width = 1;
+    summary->mode = 0;
+    summary->max = 0;
+    for (int w = 0; w < hist->size; w++)
+    {
+        int value = get_bin_value(hist, w);
+        int width = get_bin_width(hist, w);
+        sum += hist->counts[w] * value;
+
+        // The mode is the densest bin: compare count per wait value covered
+        if (hist->counts[w] * max_freq_width > max_freq * width)
+        {
+            max_freq = hist->counts[w];
+            max_freq_width = width;
+            summary->mode = value;
+        }
+        if (hist->counts[w] > 0) summary->max = value;
+    }
+    summary->mean = (double)sum / n;
+
+    double sum_sq_diff = 0.0;
+    for (int w = 0; w < hist->size; w++)
+    {
+        double diff = get_bin_value(hist, w) - summary->mean;
+        sum_sq_diff += hist->counts[w] * diff * diff;
+    }
+    summary->std_dev = sqrt(sum_sq_diff / n);
+
+    if (n % 2 == 0)
+    {
+        summary->median = (get_histogram_rank(hist, n / 2) + get_histogram_rank(hist, n / 2 + 1)) / 2.0;
+    }
+    else
+    {
+        summary->median = get_histogram_rank(hist, n / 2 + 1);
+    }
+    summary->p95 = get_histogram_percentile(hist, 95.0);
+}
+
+/**
+ * @brief Gets the mean wait of a storage in either mode.
+ */
+double get_storage_mean(const WaitTimeStorage *storage)
+{
+    if (storage->streaming) return storage->mean;
+    return get_mean(storage->wait_times, storage->count);
+}
+
+/**
+ * @brief Computes the report statistics of a run's wait times with the
+ * selected backend. STATS_SORT sorts storage in place; STATS_HISTOGRAM
+ * leaves it untouched and never sorts. A streaming storage is always
+ * summarized from its accumulators: mean, standard deviation and max are
+ * exact, and so are median, mode and percentiles below STREAM_EXACT_LIMIT
+ * minutes (within 0.2% above it).
+ */
+void summarize_wait_times(WaitTimeStorage *storage, StatsType type, WaitSummary *summary)
+{
+    if (storage->streaming)
+    {
+        summarize_histogram(&storage->hist, summary);
+        if (storage->count > 0)
+        {
+            summary->mean = storage->mean;
+            summary->std_dev = sqrt(storage->m2 / storage->count);
+            summary->max = storage->max;
+        }
+        return;
+    }
+
+    if (type == STATS_HISTOGRAM)
+    {
+        WaitHistogram hist;
+        build_histogram(&hist, storage->wait_times, storage->count);
+        summarize_histogram(&hist, summary);
+        free_histogram(&hist);
+        return;
+    }
+
+    long long n = storage->count;
+    summary->count = n;
+
+    // Sort the data IN-PLACE. This is crucial for Median and Max.
+    qsort(storage->wait_times, n, sizeof(int), compare_int);
+
+    summary->mean = get_mean(storage->wait_times, n);
+    summary->median = get_median(storage->wait_times, n);
+    summary->mode = get_mode(storage->wait_times, n);
+    summary->std_dev = get_std_dev(storage->wait_times, n, summary->mean);
+    summary->p95 = get_percentile(storage->wait_times, n, 95.0);
+    summary->max = get_max_wait(storage->wait_times, n);
+}
+
+/*
+ * ============================================================================
+ * 6. FUTURE-EVENT LIST (Binary Min-Heap) AND TELLER-STATE FUNCTIONS
+ * ============================================================================
+ */
+
+/**
+ * @brief Creates and initializes a new, empty future-event list.
+ * @param initial_capacity How many events to make room for up front.
+ * @return Pointer to the newly allocated EventHeap.
+ */
+EventHeap *create_event_heap(int initial_capacity)
+{
+    EventHeap *heap = (EventHeap *)malloc(sizeof(EventHeap));
+    if (heap == NULL)
+    {
+        perror("Failed to allocate memory for event list");
+        exit(EXIT_FAILURE);
+    }
+
+    heap->capacity = (initial_capacity < 1) ? 1 : initial_capacity;
+    heap->events = (Event *)malloc(heap->capacity * sizeof(Event));
+    if (heap->events == NULL)
+    {
+        perror("Failed to allocate memory for event array");
+        exit(EXIT_FAILURE);
+    }
+    heap->count = 0;
+    return heap;
+}
+
+/**
+ * @brief Returns 1 if event a must be handled before event b, 0 otherwise.
+ */
+int event_before(const Event *a, const Event *b)
+{
+    if (a->time != b->time) return a->time < b->time;
+    return a->type < b->type;
+}
+
+/**
+ * @brief Adds an event to the list, keeping the heap ordered. O(log n).
+ */
+void push_event(EventHeap *heap, int time, int type, int data)
+{
+    if (heap->count == heap->capacity)
+    {
+        int new_capacity = heap->capacity * 2;
+        Event *new_array = (Event *)realloc(heap->events, new_capacity * sizeof(Event));
+        if (new_array == NULL)
+        {
+            perror("Failed to re-allocate memory for event array");
+            exit(EXIT_FAILURE);
+        }
+        heap->events = new_array;
+        heap->capacity = new_capacity;
+    }
+
+    // Sift the new event up from the bottom of the heap
+    Event event = {time, type, data};
+    int i = heap->count++;
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (!event_before(&event, &heap->events[parent])) break;
+        heap->events[i] = heap->events[parent];
+        i = parent;
+    }
+    heap->events[i] = event;
+}
+
+/**
+ * @brief Places `moving` at the root slot and sifts it down to restore the
+ * heap order.
+ */
+void sift_down_event(EventHeap *heap, Event moving)
+{
+    int i = 0;
+    while (1)
+    {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && event_before(&heap->events[child + 1], &heap->events[child]))
+        {
+            child++;
+        }
+        if (!event_before(&heap->events[child], &moving)) break;
+        heap->events[i] = heap->events[child];
+        i = child;
+    }
+    heap->events[i] = moving;
+}
+
+/**
+ * @brief Removes and returns the earliest event. O(log n).
+ * @note The caller must check that the heap is not empty first.
+ */
+Event pop_event(EventHeap *heap)
+{
+    Event first = heap->events[0];
+    Event last = heap->events[--heap->count];
+    if (heap->count > 0)
+    {
+        sift_down_event(heap, last);
+    }
+    return first;
+}
+
+/**
+ * @brief Moves the earliest event to a later time in one sift instead of a
+ * pop followed by a push. O(log n).
+ * @note The heap must not be empty.
+ */
+void reschedule_first_event(EventHeap *heap, int time)
+{
+    Event first = heap->events[0];
+    first.time = time;
+    sift_down_event(heap, first);
+}
+
+/**
+ * @brief Replaces the smallest time of a min-heap of n doubles with a later
+ * one and sifts it down. O(log n). An array of equal times (such as all
+ * zeros) is already a valid heap.
+ * @param tellers Teller ids moved along with the times, or NULL when
+ * nobody needs to know which teller is which.
+ */
+void reschedule_earliest_time(double *heap, int *tellers, int n, double time)
+{
+    int teller = (tellers != NULL) ? tellers[0] : 0;
+    int i = 0;
+    while (1)
+    {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && heap[child + 1] < heap[child])
+        {
+            child++;
+        }
+        if (heap[child] >= time) break;
+        heap[i] = heap[child];
+        if (tellers != NULL) tellers[i] = tellers[child];
+        i = child;
+    }
+    heap[i] = time;
+    if (tellers != NULL) tellers[i] = teller;
+}
+
+/**
+ * @brief Frees the event array and the heap struct itself.
+ */
+void free_event_heap(EventHeap *heap)
+{
+    free(heap->events);
+    free(heap);
+}
+
+/**
+ * @brief Initializes the idle-teller stack with every teller idle. Teller 0
+ * is on top, so the first assignments go to tellers 0, 1, 2, ...
+ * One spare slot lets tick_tellers store before deciding whether to push.
+ */
+void init_idle_tellers(IdleTellers *idle, int num_tellers)
+{
+    idle->stack = (int *)malloc((num_tellers + 1) * sizeof(int));
+    if (idle->stack == NULL)
+    {
+        perror("Failed to allocate memory for idle teller stack");
+        exit(EXIT_FAILURE);
+    }
+    idle->count = 0;
+    for (int t = num_tellers - 1; t >= 0; t--)
+    {
+        idle->stack[idle->count++] = t;
+    }
+}
+
+/**
+ * @brief Marks a teller as idle. O(1).
+ */
+void push_idle_teller(IdleTellers *idle, int teller)
+{
+    idle->stack[idle->count++] = teller;
+}
+
+/**
+ * @brief Takes an idle teller off the stack. O(1).
+ * @note The caller must check that idle->count > 0 first.
+ */
+int pop_idle_teller(IdleTellers *idle)
+{
+    return idle->stack[--idle->count];
+}
+
+/**
+ * @brief Frees the idle-teller stack.
+ */
+void free_idle_tellers(IdleTellers *idle)
+{
+    free(idle->stack);
+    idle->stack = NULL;
+}
+
+/**
+ * @brief Allocates the countdowns of num_tellers tellers, all idle. The
+ * array is padded to a whole number of TELLER_BLOCK_SIZE blocks; padding
+ * counters stay 0 forever, so tick_tellers never needs a scalar tail.
+ */
+TellerClock *create_teller_clocks(int num_tellers)
+{
+    size_t padded = ((size_t)num_tellers + TELLER_BLOCK_SIZE - 1) / TELLER_BLOCK_SIZE * TELLER_BLOCK_SIZE;
+    TellerClock *remaining = (TellerClock *)calloc(padded > 0 ? padded : 1, sizeof(TellerClock));
+    if (remaining == NULL)
+    {
+        perror("Failed to allocate memory for tellers");
+        exit(EXIT_FAILURE);
+    }
+    return remaining;
+}
+
+/**
+ * @brief Advances every teller's countdown by one minute and pushes the
+ * tellers whose service ends onto the idle stack, in index order.
+ *
+ * Works in fixed-size blocks: a branch-free OR over the block detects
+ * whether any teller finishes, and a branch-free decrement of the busy
+ * counters follows. With a constant trip count both loops compile to
+ * SSE/AVX2 compares and subtracts even at -O2. Blocks that contain a
+ * finishing teller are compacted onto the idle stack without branches,
+ * since a 2-3 minute service makes "finishes now" unpredictable.
+ * @param remaining Countdowns from create_teller_clocks.
+ */
+void tick_tellers(TellerClock *remaining, int num_tellers, IdleTellers *idle)
+{
+    for (int base = 0; base < num_tellers; base += TELLER_BLOCK_SIZE)
+    {
+        TellerClock *block = remaining + base;
+
+        TellerClock finishing = 0;
+        for (int i = 0; i < TELLER_BLOCK_SIZE; i++)
+        {
+            finishing |= (block[i] == 1);
+        }
+        if (finishing)
+        {
+            int count = idle->count;
+            for (int i = 0; i < TELLER_BLOCK_SIZE; i++)
+            {
+                idle->stack[count] = base + i;
+                count += (block[i] == 1);
+            }
+            idle->count = count;
+        }
+        for (int i = 0; i < TELLER_BLOCK_SIZE; i++)
+        {
+            block[i] -= (block[i] != 0);
+        }
+    }
+}
+
+/*
+ * ============================================================================
+ * 7. PARALLEL EXECUTION HELPERS
+ * ============================================================================
+ */
+
+/**
+ * @brief A unit of parallel work: runs task number `task` using `context`.
+ */
+typedef void (*TaskFunction)(void *context, int task);
+
+/**
+ * @brief Shared state of the worker threads started by run_parallel.
+ */
+typedef struct TaskPool
+{
+    TaskFunction function; // Work to run for each task number
+    void *context;         // Passed unchanged to every task
+    int num_tasks;         // Tasks are numbered 0 .. num_tasks - 1
+    atomic_int next_task;  // Next task number nobody has claimed yet
+} TaskPool;
+
+/**
+ * @brief Gets the number of CPUs available to run worker threads.
+ */
+int get_cpu_count()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus < 1) ? 1 : (int)cpus;
+}
+
+/**
+ * @brief Worker thread body: keeps claiming the next unclaimed task until
+ * all of them are taken.
+ */
+void *task_worker(void *arg)
+{
+    TaskPool *pool = (TaskPool *)arg;
+    int task;
+    while ((task = atomic_fetch_add(&pool->next_task, 1)) < pool->num_tasks)
+    {
+        pool->function(pool->context, task);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs tasks 0 .. num_tasks - 1 on up to num_threads threads and
+ * returns when all of them have finished. Tasks must only write to their
+ * own slot of shared output, so the result never depends on scheduling.
+ * @param num_threads Thread count, or 0 to use one thread per CPU.
+ */
+void run_parallel(int num_tasks, int num_threads, TaskFunction function, void *context)
+{
+    if (num_threads <= 0) num_threads = get_cpu_count();
+    if (num_threads > num_tasks) num_threads = num_tasks;
+
+    TaskPool pool;
+    pool.function = function;
+    pool.context = context;
+    pool.num_tasks = num_tasks;
+    atomic_init(&pool.next_task, 0);
+
+    if (num_threads <= 1)
+    {
+        task_worker(&pool);
+        return;
+    }
+
+    pthread_t *threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
+    if (threads == NULL)
+    {
+        perror("Failed to allocate memory for worker threads");
+        exit(EXIT_FAILURE);
+    }
+
+    // The calling thread works too, so only num_threads - 1 are started
+    int started = 0;
+    for (int i = 0; i < num_threads - 1; i++)
+    {
+        if (pthread_create(&threads[started], NULL, task_worker, &pool) == 0)
+        {
+            started++;
+        }
+    }
+    task_worker(&pool);
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+}
+
+/**
+ * @brief Journey writer thread body: writes each buffer the simulation
+ * hands over, then frees it for reuse, until the writer is closed.
+ */
+void *journey_worker(void *arg)
+{
+    JourneyWriter *writer = (JourneyWriter *)arg;
+    // The first buffer handed over is buffers[0], then they alternate
+    int next = 0;
+    pthread_mutex_lock(&writer->lock);
+    while (1)
+    {
+        while (writer->pending_count == 0 && !writer->closing)
+        {
+            pthread_cond_wait(&writer->changed, &writer->lock);
+        }
+        if (writer->pending_count == 0) break;
+        int count = writer->pending_count;
+        pthread_mutex_unlock(&writer->lock);
+
+        size_t written = fwrite(writer->buffers[next], sizeof(JourneyRecord), count, writer->file);
+        next ^= 1;
+
+        pthread_mutex_lock(&writer->lock);
+        if (written != (size_t)count) writer->failed = 1;
+        writer->pending_count = 0;
+        pthread_cond_signal(&writer->changed);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+/**
+ * @brief Writes the JourneyHeader to `file` and starts the background
+ * thread that writes the records after it. The writer owns `file` from
+ * here on and closes it in close_journey_writer.
+ */
+JourneyWriter *create_journey_writer(FILE *file, uint32_t ticks_per_minute, uint64_t seed)
+{
+    JourneyWriter *writer = (JourneyWriter *)calloc(1, sizeof(JourneyWriter));
+    JourneyRecord *buffers = (JourneyRecord *)malloc(2 * JOURNEY_BUFFER_RECORDS * sizeof(JourneyRecord));
+    if (writer == NULL || buffers == NULL)
+    {
+        perror("Failed to allocate memory for journey buffers");
+        exit(EXIT_FAILURE);
+    }
+    writer->file = file;
+    writer->buffers[0] = buffers;
+    writer->buffers[1] = buffers + JOURNEY_BUFFER_RECORDS;
+    writer->fill = writer->buffers[0];
+
+    JourneyHeader header;
+    memcpy(header.magic, JOURNEY_MAGIC, sizeof(header.magic));
+    header.ticks_per_minute = ticks_per_minute;
+    header.record_size = sizeof(JourneyRecord);
+    header.seed = seed;
+    // Whole buffers go straight to the file, so stdio's own copy is skipped
+    setvbuf(file, NULL, _IONBF, 0);
+    if (fwrite(&header, sizeof(header), 1, file) != 1)
+    {
+        perror("Failed to write journey header");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->changed, NULL);
+    if (pthread_create(&writer->thread, NULL, journey_worker, writer) != 0)
+    {
+        perror("Failed to start journey writer thread");
+        exit(EXIT_FAILURE);
+    }
+    return writer;
+}
+
+/**
+ * @brief Hands the filled buffer to the writer thread and switches to the
+ * other one, first waiting for the thread to finish writing it. Runs once
+ * per JOURNEY_BUFFER_RECORDS records, so it is kept out of line.
+ */
+__attribute__((cold, noinline)) void flush_journey_buffer(JourneyWriter *writer)
+{
+    pthread_mutex_lock(&writer->lock);
+    while (writer->pending_count > 0)
+    {
+        pthread_cond_wait(&writer->changed, &writer->lock);
+    }
+    writer->pending_count = writer->fill_count;
+    pthread_cond_signal(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+
+    writer->records += writer->fill_count;
+    writer->fill = (writer->fill == writer->buffers[0]) ? writer->buffers[1] : writer->buffers[0];
+    writer->fill_count = 0;
+}
+
+/**
+ * @brief Appends one customer's journey. Inlined into the engines' loops,
+ * where it costs a 16-byte store and a compare; every
+ * JOURNEY_BUFFER_RECORDS records the buffers swap.
+ */
+static inline void record_journey(JourneyWriter *writer, uint32_t arrival, uint32_t start,
+                                  uint32_t end, int teller)
+{
+    JourneyRecord *record = &writer->fill[writer->fill_count];
+    record->arrival = arrival;
+    record->start = start;
+    record->end = end;
+    record->teller = (uint32_t)teller;
+    if (__builtin_expect(++writer->fill_count == JOURNEY_BUFFER_RECORDS, 0))
+    {
+        flush_journey_buffer(writer);
+    }
+}
+
+/**
+ * @brief Writes the remaining records, stops the writer thread, closes the
+ * file and frees the writer.
+ * @return The number of records written.
+ */
+long long close_journey_writer(JourneyWriter *writer)
+{
+    if (writer->fill_count > 0)
+    {
+        flush_journey_buffer(writer);
+    }
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = 1;
+    pthread_cond_signal(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    if (fclose(writer->file) != 0 || writer->failed)
+    {
+        perror("Failed to write journey file");
+        exit(EXIT_FAILURE);
+    }
+    long long records = writer->records;
+    pthread_cond_destroy(&writer->changed);
+    pthread_mutex_destroy(&writer->lock);
+    free(writer->buffers[0]);
+    free(writer);
+    return records;
+}
+
+/*
+ * ============================================================================
+ * 8. MAIN SIMULATION FUNCTIONS
+ * ============================================================================
+ */
+
+/**
+ * @brief The original engine: advances the clock one minute at a time.
+ * Idle tellers are tracked on a stack, so handing customers to them costs
+ * only the assignments actually made.
+ *
+ * With TELLERS_COUNTDOWN every busy teller's remaining time is decremented
+ * each minute, costing O(num_tellers) per minute. With TELLERS_HEAP each
+ * assignment schedules the teller's absolute completion minute in a
+ * min-heap and only tellers whose service actually ends are touched,
+ * costing O(completions * log num_tellers) per minute.
+ *
+ * Arrivals come from an ArrivalSource, which samples the geometric gap to
+ * the next non-empty minute directly. Whenever the queue is empty and every
+ * teller is idle the loop jumps straight to that minute, so quiet stretches
+ * cost O(1) rather than O(length).
+ */
+void simulate_minute_stepped(const SimConfig *config, Rng *rng, SimResult *result)
+{
+    int num_tellers = config->num_tellers;
+
+    // Create the bank queue
+    CustomerPool *pool = create_pool();
+    Queue *bank_queue = create_queue(config->queue_type, pool);
+
+    // Create the tellers' countdowns, all free (0 minutes remaining)
+    TellerClock *remaining = create_teller_clocks(num_tellers);
+    IdleTellers idle;
+    init_idle_tellers(&idle, num_tellers);
+
+    EventHeap *completions = NULL;
+    if (config->teller_mode == TELLERS_HEAP)
+    {
+        completions = create_event_heap(num_tellers);
+    }
+
+    ArrivalSource arrivals;
+    open_arrivals(&arrivals, rng, config);
+
+    // Arrival minutes of the customers handed to tellers in one minute
+    int *taken = (int *)malloc(num_tellers * sizeof(int));
+    if (taken == NULL) {
+        perror("Failed to allocate memory for dequeued customers");
+        exit(EXIT_FAILURE);
+    }
+
+    // Run the main simulation loop
+    for (int current_minute = 0; current_minute < config->sim_minutes; current_minute++)
+    {
+        // --- Step 1: Handle Tellers (Decrement service time, free them up) ---
+        if (completions != NULL)
+        {
+            // Only tellers finishing this minute are at the top of the heap
+            while (completions->count > 0 && completions->events[0].time <= current_minute)
+            {
+                int t = pop_event(completions).data;
+                remaining[t] = 0;
+                push_idle_teller(&idle, t);
+            }
+        }
+        else
+        {
+            tick_tellers(remaining, num_tellers, &idle);
+        }
+
+        // --- Step 2: Handle New Customer Arrivals ---
+        if (idle.count == num_tellers && is_empty(bank_queue))
+        {
+            // Nothing can change until someone arrives, so jump straight to
+            // the next non-empty minute
+            if (arrivals.minute >= config->sim_minutes)
+            {
+                break;
+            }
+            current_minute = (int)arrivals.minute;
+        }
+        int new_arrivals = 0;
+        if (arrivals.minute == current_minute)
+        {
+            new_arrivals = arrivals.count;
+            advance_arrivals(&arrivals);
+        }
+        result->total_arrivals += new_arrivals;
+        enqueue_n(bank_queue, current_minute, new_arrivals);
+
+        // --- Step 3: Assign Free Tellers to Waiting Customers ---
+        // Take one waiting customer per free teller (or everyone, if fewer)
+        int num_taken = dequeue_n(bank_queue, idle.count, taken);
+        for (int i = 0; i < num_taken; i++)
+        {
+            // 1. Calculate and store their wait time
+            int wait_time = current_minute - taken[i];
+            add_wait_time(result->storage, wait_time);
+
+            // 2. Occupy the teller
+            int t = pop_idle_teller(&idle);
+            remaining[t] = (TellerClock)get_service_time(rng, &config->service);
+            if (completions != NULL)
+            {
+                push_event(completions, current_minute + remaining[t], EVENT_COMPLETION, t);
+            }
+            if (result->journey != NULL)
+            {
+                record_journey(result->journey, taken[i], current_minute, current_minute + remaining[t], t);
+            }
+        }
+    } // --- End of simulation loop ---
+
+    result->customers_left = bank_queue->customer_count;
+
+    close_arrivals(&arrivals);
+    free(taken);
+    if (completions != NULL)
+    {
+        free_event_heap(completions);
+    }
+    free_idle_tellers(&idle);
+    free(remaining);
+    free_queue(bank_queue);
+    free_pool(pool);
+}
+
+/**
+ * @brief The next-event engine: keeps a future-event list of arrival batches
+ * and service completions and jumps straight from one event minute to the
+ * next, so cost grows with the number of events instead of the horizon.
+ *
+ * Within a minute the order matches simulate_minute_stepped: completions
+ * free their tellers, then the minute's arrivals join the queue, then free
+ * tellers take waiting customers. Only minutes with arrivals are
+ * scheduled, as drawn by the ArrivalSource.
+ */
+void simulate_event_driven(const SimConfig *config, Rng *rng, SimResult *result)
+{
+    int num_tellers = config->num_tellers;
+
+    CustomerPool *pool = create_pool();
+    Queue *bank_queue = create_queue(config->queue_type, pool);
+    EventHeap *events = create_event_heap(num_tellers + 1);
+
+    // Free tellers are kept on a stack so assignment never scans busy ones
+    IdleTellers idle;
+    init_idle_tellers(&idle, num_tellers);
+    int *taken = (int *)malloc(num_tellers * sizeof(int));
+    if (taken == NULL)
+    {
+        perror("Failed to allocate memory for dequeued customers");
+        exit(EXIT_FAILURE);
+    }
+
+    // Schedule the first arrival batch
+    ArrivalSource arrivals;
+    open_arrivals(&arrivals, rng, config);
+    if (arrivals.minute < config->sim_minutes)
+    {
+        push_event(events, (int)arrivals.minute, EVENT_ARRIVAL, arrivals.count);
+    }
+
+    while (events->count > 0 && events->events[0].time < config->sim_minutes)
+    {
+        int current_minute = events->events[0].time;
+
+        // --- Steps 1 & 2: Fire every event scheduled for this minute ---
+        while (events->count > 0 && events->events[0].time == current_minute)
+        {
+            Event event = pop_event(events);
+            if (event.type == EVENT_COMPLETION)
+            {
+                push_idle_teller(&idle, event.data);
+            }
+            else
+            {
+                result->total_arrivals += event.data;
+                enqueue_n(bank_queue, current_minute, event.data);
+
+                // Schedule the following arrival batch, if it falls inside the horizon
+                advance_arrivals(&arrivals);
+                if (arrivals.minute < config->sim_minutes)
+                {
+                    push_event(events, (int)arrivals.minute, EVENT_ARRIVAL, arrivals.count);
+                }
+            }
+        }
+
+        // --- Step 3: Assign Free Tellers to Waiting Customers ---
+        int num_taken = dequeue_n(bank_queue, idle.count, taken);
+        for (int i = 0; i < num_taken; i++)
+        {
+            add_wait_time(result->storage, current_minute - taken[i]);
+
+            int teller = pop_idle_teller(&idle);
+            long long done = (long long)current_minute + get_service_time(rng, &config->service);
+            if (result->journey != NULL)
+            {
+                record_journey(result->journey, taken[i], current_minute, (uint32_t)done, teller);
+            }
+            if (done < config->sim_minutes)
+            {
+                push_event(events, (int)done, EVENT_COMPLETION, teller);
+            }
+        }
+    }
+
+    result->customers_left = bank_queue->customer_count;
+
+    close_arrivals(&arrivals);
+    free(taken);
+    free_idle_tellers(&idle);
+    free_event_heap(events);
+    free_queue(bank_queue);
+    free_pool(pool);
+}
+
+/**
+ * @brief Gets the name of a simulation engine, for reports.
+ */
+const char *get_engine_name(EngineType engine)
+{
+    switch (engine)
+    {
+    case ENGINE_EVENT:
+        return "event-driven";
+    case ENGINE_LINDLEY:
+        return "Kiefer-Wolfowitz";
+    case ENGINE_SCAN:
+        return "parallel max-plus scan";
+    case ENGINE_CONTINUOUS:
+        return "continuous-time";
+    default:
+        return "minute-stepped";
+    }
+}
+
+/**
+ * @brief Gets the unit wait times are recorded in: seconds for the
+ * continuous-time engine, whole minutes for every other engine.
+ */
+const char *get_wait_unit(const SimConfig *config)
+{
+    return (config->engine == ENGINE_CONTINUOUS) ? "seconds" : "minutes";
+}
+
+/**
+ * @brief Prints the summary and wait-time statistics of a finished run.
+ * @note With --stats=sort this sorts result->storage in place.
+ */
+void print_report(const SimConfig *config, SimResult *result)
+{
+    WaitTimeStorage *storage = result->storage;
+
+    printf("========== 📊 FINAL SIMULATION REPORT 📊 ==========\n");
+    printf("\n--- Simulation Summary ---\n");
+    printf("Total Customers Arrived: %lld\n", result->total_arrivals);
+    printf("Total Customers Served:  %lld\n", storage->count);
+    printf("Customers Left in Queue: %lld\n", result->customers_left);
+
+    if (storage->count == 0)
+    {
+        printf("\nNo customers were served. Cannot generate wait-time statistics.\n");
+    }
+    else
+    {
+        const char *unit = get_wait_unit(config);
+        printf("\n--- Wait Time Analysis (in %s) ---\n", unit);
+
+        // Calculate all statistics
+        WaitSummary summary;
+        summarize_wait_times(storage, config->stats_type, &summary);
+
+        // Print the report
+        printf("Mean (Average) Wait: %.2f %s\n", summary.mean, unit);
+        printf("Median Wait:         %.1f %s\n", summary.median, unit);
+        printf("Mode Wait:           %d %s\n", summary.mode, unit);
+        printf("Standard Deviation:  %.2f %s\n", summary.std_dev, unit);
+        printf("Longest Wait Time:   %d %s\n", summary.max, unit);
+    }
+    printf("===================================================\n");
+}
+
+/**
+ * @brief The Kiefer-Wolfowitz engine: with FIFO service by identical
+ * tellers, customer n starts at max(arrival_n, earliest teller free time)
+ * and that teller is then busy until start + service_n. Keeping the
+ * tellers' free times in a min-heap (the workload vector) gives every wait
+ * in O(log num_tellers) per customer, with no clock, queue or teller state.
+ * With one teller this is Lindley's recursion.
+ *
+ * A teller free at minute f can start someone arriving at minute f, and
+ * service times are drawn in FIFO order, so for the same stream the waits
+ * match the minute-stepped and event-driven engines customer by customer.
+ * Only valid while arrivals and tellers do not vary over the day.
+ */
+void simulate_lindley(const SimConfig *config, Rng *rng, SimResult *result)
+{
+    int num_tellers = config->num_tellers;
+
+    EventHeap *free_at = create_event_heap(num_tellers);
+    for (int t = 0; t < num_tellers; t++)
+    {
+        push_event(free_at, 0, EVENT_COMPLETION, t);
+    }
+
+    ArrivalSource arrivals;
+    open_arrivals(&arrivals, rng, config);
+
+    long long served = 0;
+    while (arrivals.minute < config->sim_minutes)
+    {
+        int arrival_minute = (int)arrivals.minute;
+        result->total_arrivals += arrivals.count;
+        for (int i = 0; i < arrivals.count; i++)
+        {
+            int earliest = free_at->events[0].time;
+            int start = (arrival_minute > earliest) ? arrival_minute : earliest;
+            if (start >= config->sim_minutes)
+            {
+                // Starts never decrease in FIFO order: everyone from here on
+                // is still waiting at closing time
+                break;
+            }
+            add_wait_time(result->storage, start - arrival_minute);
+            served++;
+            int end = start + get_service_time(rng, &config->service);
+            if (result->journey != NULL)
+            {
+                // The heap's top entry is the teller taking this customer
+                record_journey(result->journey, arrival_minute, start, end, free_at->events[0].data);
+            }
+            reschedule_first_event(free_at, end);
+        }
+        advance_arrivals(&arrivals);
+    }
+
+    result->customers_left = result->total_arrivals - served;
+
+    close_arrivals(&arrivals);
+    free_event_heap(free_at);
+}
+
+/**
+ * @brief Shared state of the parallel max-plus scan over one day.
+ */
+typedef struct ScanBatch
+{
+    const SimConfig *config;
+    const Rng *streams;         // One random number stream per chunk
+    TellerTransfer *transfers;  // Pass 1: each chunk's map on the teller's free minute
+    long long *free_at;         // Teller free minute entering each chunk
+    SimResult *results;         // Pass 2: each chunk's waits
+} ScanBatch;
+
+/**
+ * @brief Walks the customers of one chunk of SCAN_CHUNK_MINUTES minutes,
+ * drawing its arrivals and service times from the chunk's own stream.
+ * Without `result` it only composes the chunk's TellerTransfer; with it,
+ * it replays the chunk from the free minute found by the scan and records
+ * every wait that starts inside the horizon.
+ */
+void walk_scan_chunk(ScanBatch *batch, int chunk, SimResult *result)
+{
+    const SimConfig *config = batch->config;
+    long long first = (long long)chunk * SCAN_CHUNK_MINUTES;
+    long long end = first + SCAN_CHUNK_MINUTES;
+    if (end > config->sim_minutes) end = config->sim_minutes;
+
+    Rng rng = batch->streams[chunk];
+    ArrivalSource arrivals;
+    open_arrivals_from(&arrivals, &rng, config, first);
+
+    TellerTransfer transfer = {0, LLONG_MIN};
+    long long free_at = batch->free_at[chunk];
+    long long served = 0, arrived = 0;
+    while (first + arrivals.minute < end)
+    {
+        long long arrival = first + arrivals.minute;
+        arrived += arrivals.count;
+        for (int i = 0; i < arrivals.count; i++)
+        {
+            int service = get_service_time(&rng, &config->service);
+            if (result == NULL)
+            {
+                // Compose with this customer's map F -> max(F, arrival) + service
+                transfer.shift += service;
+                transfer.floor = ((transfer.floor > arrival) ? transfer.floor : arrival) + service;
+                continue;
+            }
+            long long start = (arrival > free_at) ? arrival : free_at;
+            if (start < config->sim_minutes)
+            {
+                add_wait_time(result->storage, (int)(start - arrival));
+                served++;
+            }
+            free_at = start + service;
+        }
+        advance_arrivals(&arrivals);
+    }
+    close_arrivals(&arrivals);
+
+    if (result == NULL)
+    {
+        batch->transfers[chunk] = transfer;
+    }
+    else
+    {
+        result->total_arrivals = arrived;
+        result->customers_left = arrived - served;
+    }
+}
+
+/**
+ * @brief Pass-1 task body for run_parallel: composes a chunk's transfer.
+ */
+void run_scan_transfer_task(void *context, int chunk)
+{
+    walk_scan_chunk((ScanBatch *)context, chunk, NULL);
+}
+
+/**
+ * @brief Pass-2 task body for run_parallel: replays a chunk's waits.
+ */
+void run_scan_replay_task(void *context, int chunk)
+{
+    ScanBatch *batch = (ScanBatch *)context;
+    SimResult *result = &batch->results[chunk];
+    result->storage = create_storage(batch->config->stats_type);
+    result->journey = NULL;
+    walk_scan_chunk(batch, chunk, result);
+}
+
+/**
+ * @brief Splits one long single-teller day across cores. With one teller
+ * Lindley's recursion is F' = max(F, arrival) + service, a max-plus affine
+ * map of the teller's free minute F, and such maps compose associatively.
+ *
+ * The horizon is cut into chunks of SCAN_CHUNK_MINUTES with one stream
+ * each (Poisson arrivals in disjoint minutes are independent). Pass 1
+ * computes every chunk's TellerTransfer in parallel, an exclusive prefix
+ * scan over the transfers gives the free minute entering each chunk, and
+ * pass 2 replays the chunks in parallel from those minutes. Chunk waits
+ * are merged in chunk order, so the result does not depend on the number
+ * of threads; it costs about twice the draws of simulate_lindley, spread
+ * over every core.
+ *
+ * Chunk k draws from `rng` jumped k times, so the day needs the streams
+ * of its seed to itself: one teller and one replication only.
+ */
+void simulate_max_plus_scan(const SimConfig *config, Rng *rng, SimResult *result)
+{
+    int num_chunks = (int)(((long long)config->sim_minutes + SCAN_CHUNK_MINUTES - 1) / SCAN_CHUNK_MINUTES);
+    Rng *streams = (Rng *)malloc(num_chunks * sizeof(Rng));
+    TellerTransfer *transfers = (TellerTransfer *)malloc(num_chunks * sizeof(TellerTransfer));
+    long long *free_at = (long long *)malloc(num_chunks * sizeof(long long));
+    SimResult *results = (SimResult *)malloc(num_chunks * sizeof(SimResult));
+    if (streams == NULL || transfers == NULL || free_at == NULL || results == NULL)
+    {
+        perror("Failed to allocate memory for scan chunks");
+        exit(EXIT_FAILURE);
+    }
+    Rng chunk_rng = *rng;
+    for (int k = 0; k < num_chunks; k++)
+    {
+        streams[k] = chunk_rng;
+        rng_jump(&chunk_rng);
+    }
+
+    ScanBatch batch = {config, streams, transfers, free_at, results};
+    run_parallel(num_chunks, config->num_threads, run_scan_transfer_task, &batch);
+
+    // Exclusive prefix scan; the teller starts free at minute 0. There is
+    // one transfer per 45 days of minutes, so this part stays sequential.
+    free_at[0] = 0;
+    for (int k = 0; k + 1 < num_chunks; k++)
+    {
+        long long shifted = free_at[k] + transfers[k].shift;
+        free_at[k + 1] = (shifted > transfers[k].floor) ? shifted : transfers[k].floor;
+    }
+
+    run_parallel(num_chunks, config->num_threads, run_scan_replay_task, &batch);
+
+    for (int k = 0; k < num_chunks; k++)
+    {
+        result->total_arrivals += results[k].total_arrivals;
+        result->customers_left += results[k].customers_left;
+        append_wait_times(result->storage, results[k].storage);
+        free_storage(results[k].storage);
+    }
+
+    free(results);
+    free(free_at);
+    free(transfers);
+    free(streams);
+}
+
+/**
+ * @brief Converts a continuous-time instant in minutes to the whole
+ * seconds a JourneyRecord holds, saturating past 136 years.
+ */
+uint32_t get_journey_seconds(double minutes)
+{
+    // Times are never negative, so adding a half and truncating rounds
+    double seconds = minutes * 60.0 + 0.5;
+    return (seconds < UINT32_MAX) ? (uint32_t)seconds : UINT32_MAX;
+}
+
+/**
+ * @brief The continuous-time engine: exponential inter-arrival times at
+ * rate lambda per minute and real-valued service times (by default
+ * uniform on [MIN_SERVICE_TIME, MAX_SERVICE_TIME] minutes), with no
+ * rounding to whole minutes. FIFO service by identical tellers is again
+ * the Kiefer-Wolfowitz recursion, here over a min-heap of the tellers'
+ * real-valued free times, so the cost is O(log num_tellers) per customer
+ * however fine the time resolution. Waits are recorded in whole seconds
+ * (rounded to nearest), which is what the report shows for this engine.
+ */
+void simulate_continuous(const SimConfig *config, Rng *rng, SimResult *result)
+{
+    int num_tellers = config->num_tellers;
+    double horizon = config->sim_minutes;
+
+    // Every teller is free from time 0
+    double *free_at = (double *)calloc(num_tellers, sizeof(double));
+    if (free_at == NULL)
+    {
+        perror("Failed to allocate memory for teller free times");
+        exit(EXIT_FAILURE);
+    }
+
+    // Which teller each heap slot belongs to, kept only for --journey
+    int *tellers = NULL;
+    if (result->journey != NULL)
+    {
+        tellers = (int *)malloc(num_tellers * sizeof(int));
+        if (tellers == NULL)
+        {
+            perror("Failed to allocate memory for teller ids");
+            exit(EXIT_FAILURE);
+        }
+        for (int t = 0; t < num_tellers; t++)
+        {
+            tellers[t] = t;
+        }
+    }
+
+    // Arrivals use their own substream, as with ArrivalSource, or are
+    // replayed at their exact recorded times
+    Rng arrival_rng = *rng;
+    rng_long_jump(&arrival_rng);
+    TraceCursor cursor;
+    if (config->trace != NULL)
+    {
+        open_trace_cursor(&cursor, config->trace);
+    }
+
+    long long served = 0;
+    double arrival = 0.0;
+    while (1)
+    {
+        if (config->trace != NULL)
+        {
+            double seconds;
+            if (!read_trace_seconds(&cursor, &seconds)) break;
+            arrival = (seconds - config->trace->origin) / 60.0;
+        }
+        else if (config->profile.num_steps > 0)
+        {
+            arrival = get_next_profile_time(&arrival_rng, config, arrival);
+        }
+        else
+        {
+            arrival += -log(get_open_uniform(&arrival_rng)) / config->lambda;
+        }
+        if (arrival >= horizon) break;
+        result->total_arrivals++;
+
+        double start = (arrival > free_at[0]) ? arrival : free_at[0];
+        if (start >= horizon)
+        {
+            // Starts never decrease in FIFO order: this customer and every
+            // later one is still waiting at closing time
+            continue;
+        }
+        double wait_seconds = (start - arrival) * 60.0;
+        add_wait_time(result->storage, (wait_seconds < INT_MAX) ? (int)lround(wait_seconds) : INT_MAX);
+        served++;
+        double end = start + get_service_minutes(rng, &config->service);
+        if (tellers != NULL)
+        {
+            record_journey(result->journey, get_journey_seconds(arrival), get_journey_seconds(start),
+                           get_journey_seconds(end), tellers[0]);
+        }
+        reschedule_earliest_time(free_at, tellers, num_tellers, end);
+    }
+
+    result->customers_left = result->total_arrivals - served;
+
+    free(tellers);
+    free(free_at);
+}
+
+/**
+ * @brief Runs one simulated day with the engine selected in the config.
+ * @param rng The random number stream this run draws from.
+ * @param result Receives the run's counters; result->storage must exist.
+ */
+void simulate_day(const SimConfig *config, Rng *rng, SimResult *result)
+{
+    if (config->engine == ENGINE_CONTINUOUS)
+    {
+        simulate_continuous(config, rng, result);
+    }
+    else if (config->engine == ENGINE_SCAN)
+    {
+        simulate_max_plus_scan(config, rng, result);
+    }
+    else if (config->engine == ENGINE_LINDLEY)
+    {
+        simulate_lindley(config, rng, result);
+    }
+    else if (config->engine == ENGINE_EVENT)
+    {
+        simulate_event_driven(config, rng, result);
+    }
+    else
+    {
+        simulate_minute_stepped(config, rng, result);
+    }
+}
+
+/**
+ * @brief Shared state of a batch of replications running on worker threads.
+ */
+typedef struct ReplicationBatch
+{
+    const SimConfig *config;
+    const Rng *streams; // One random number stream per replication
+    SimResult *results; // One slot per replication
+} ReplicationBatch;
+
+/**
+ * @brief Task body for run_parallel: simulates replication number
+ * `replication` on its own random number stream.
+ */
+void run_replication_task(void *context, int replication)
+{
+    ReplicationBatch *batch = (ReplicationBatch *)context;
+    SimResult *result = &batch->results[replication];
+
+    Rng rng = batch->streams[replication];
+    result->total_arrivals = 0;
+    result->customers_left = 0;
+    result->storage = create_storage(batch->config->stats_type);
+    result->journey = NULL;
+    simulate_day(batch->config, &rng, result);
+}
+
+/**
+ * @brief Simulates config->replications independent days in parallel and
+ * prints a pooled report plus confidence intervals across days.
+ *
+ * Replication r always uses stream r of config->seed and the results are
+ * merged in replication order, so the output is bit-identical for any
+ * number of threads.
+ */
+void run_replications(const SimConfig *config)
+{
+    int n = config->replications;
+    SimResult *results = (SimResult *)malloc(n * sizeof(SimResult));
+    double *mean_waits = (double *)malloc(n * sizeof(double));
+    double *served = (double *)malloc(n * sizeof(double));
+    double *left = (double *)malloc(n * sizeof(double));
+    if (results == NULL || mean_waits == NULL || served == NULL || left == NULL)
+    {
+        perror("Failed to allocate memory for replication results");
+        exit(EXIT_FAILURE);
+    }
+
+    Rng *streams = create_streams(config->seed, n);
+    ReplicationBatch batch = {config, streams, results};
+    run_parallel(n, config->num_threads, run_replication_task, &batch);
+    free(streams);
+
+    printf("... %d replications complete.\n\n", n);
+
+    // Pool every day's wait times, always in replication order
+    SimResult pooled = {0, 0, create_storage(config->stats_type), NULL};
+    for (int r = 0; r < n; r++)
+    {
+        mean_waits[r] = get_storage_mean(results[r].storage);
+        served[r] = results[r].storage->count;
+        left[r] = (double)results[r].customers_left;
+
+        pooled.total_arrivals += results[r].total_arrivals;
+        pooled.customers_left += results[r].customers_left;
+        append_wait_times(pooled.storage, results[r].storage);
+        free_storage(results[r].storage);
+    }
+
+    printf("(Pooled over %d simulated days)\n", n);
+    print_report(config, &pooled);
+
+    printf("\n--- Per-Day Averages (95%% confidence intervals) ---\n");
+    print_interval("Mean Wait:", mean_waits, n, get_wait_unit(config));
+    print_interval("Customers Served:", served, n, "per day");
+    print_interval("Left in Queue:", left, n, "per day");
+    printf("===================================================\n");
+
+    free_storage(pooled.storage);
+    free(left);
+    free(served);
+    free(mean_waits);
+    free(results);
+}
+
+/**
+ * @brief Gets how many values a sweep range covers.
+ */
+int get_range_count(const SweepRange *range)
+{
+    if (range->step <= 0.0 || range->last <= range->first) return 1;
+    return (int)floor((range->last - range->first) / range->step + 1e-9) + 1;
+}
+
+/**
+ * @brief Shared state of a parameter sweep running on worker threads.
+ */
+typedef struct SweepBatch
+{
+    const SimConfig *config; // Base config; lambda and num_tellers are overridden
+    const SweepSpec *spec;
+    Rng *streams;            // One random number stream per replication
+    int lambda_count;        // Number of lambda values in the grid
+    SimResult *results;      // One slot per (grid point, replication)
+    double *rows;            // SWEEP_COLUMNS values per grid point
+} SweepBatch;
+
+#define SWEEP_COLUMNS 8 // lambda, tellers, mean, median, p95, max, served, left
+
+/**
+ * @brief Fills in the config of grid point `point` from the sweep ranges.
+ */
+void get_sweep_point(const SweepBatch *batch, int point, SimConfig *config)
+{
+    *config = *batch->config;
+    config->lambda = batch->spec->lambda.first + (point % batch->lambda_count) * batch->spec->lambda.step;
+    config->num_tellers = (int)(batch->spec->tellers.first + (point / batch->lambda_count) * batch->spec->tellers.step);
+}
+
+/**
+ * @brief Task body for run_parallel: simulates one replication of one grid
+ * point. Replication r uses stream r of the seed at every grid point, so
+ * neighbouring points are compared on common random numbers.
+ */
+void run_sweep_task(void *context, int task)
+{
+    SweepBatch *batch = (SweepBatch *)context;
+    int replications = batch->config->replications;
+
+    SimConfig config;
+    get_sweep_point(batch, task / replications, &config);
+
+    Rng rng = batch->streams[task % replications];
+
+    SimResult *result = &batch->results[task];
+    result->total_arrivals = 0;
+    result->customers_left = 0;
+    result->storage = create_storage(config.stats_type);
+    result->journey = NULL;
+    simulate_day(&config, &rng, result);
+}
+
+/**
+ * @brief Task body for run_parallel: pools the replications of grid point
+ * `point` and computes its output row.
+ */
+void summarize_sweep_point(void *context, int point)
+{
+    SweepBatch *batch = (SweepBatch *)context;
+    int replications = batch->config->replications;
+    SimResult *results = &batch->results[point * replications];
+
+    SimConfig config;
+    get_sweep_point(batch, point, &config);
+
+    WaitTimeStorage *pooled = create_storage(config.stats_type);
+    long long left = 0;
+    for (int r = 0; r < replications; r++)
+    {
+        append_wait_times(pooled, results[r].storage);
+        left += results[r].customers_left;
+        free_storage(results[r].storage);
+    }
+    WaitSummary summary;
+    summarize_wait_times(pooled, config.stats_type, &summary);
+
+    double *row = &batch->rows[point * SWEEP_COLUMNS];
+    row[0] = config.lambda;
+    row[1] = config.num_tellers;
+    row[2] = summary.mean;
+    row[3] = summary.median;
+    row[4] = summary.p95;
+    row[5] = summary.max;
+    row[6] = (double)pooled->count / replications;
+    row[7] = (double)left / replications;
+    free_storage(pooled);
+}
+
+/**
+ * @brief Simulates every (lambda, num_tellers) grid point times
+ * config->replications days on the worker pool and writes one CSV row per
+ * grid point. Served and left-in-queue counts are per-day averages; the
+ * wait statistics are pooled over the point's replications.
+ */
+void run_sweep(const SimConfig *config, const SweepSpec *spec)
+{
+    SweepBatch batch;
+    batch.config = config;
+    batch.spec = spec;
+    batch.streams = create_streams(config->seed, config->replications);
+    batch.lambda_count = get_range_count(&spec->lambda);
+    int num_points = batch.lambda_count * get_range_count(&spec->tellers);
+    int num_tasks = num_points * config->replications;
+
+    batch.results = (SimResult *)malloc(num_tasks * sizeof(SimResult));
+    batch.rows = (double *)malloc(num_points * SWEEP_COLUMNS * sizeof(double));
+    if (batch.results == NULL || batch.rows == NULL)
+    {
+        perror("Failed to allocate memory for sweep results");
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *out = stdout;
+    if (spec->output_path != NULL)
+    {
+        out = fopen(spec->output_path, "w");
+        if (out == NULL)
+        {
+            perror("Failed to open sweep output file");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    fprintf(stderr, "Sweeping %d grid points x %d replications (seed %llu)...\n",
+            num_points, config->replications, (unsigned long long)config->seed);
+    run_parallel(num_tasks, config->num_threads, run_sweep_task, &batch);
+    run_parallel(num_points, config->num_threads, summarize_sweep_point, &batch);
+
+    // Wait columns carry their unit: seconds for the continuous-time engine
+    const char *unit = (config->engine == ENGINE_CONTINUOUS) ? "s" : "min";
+    fprintf(out, "lambda,tellers,mean_wait_%s,median_wait_%s,p95_wait_%s,max_wait_%s,served,left_in_queue\n",
+            unit, unit, unit, unit);
+    for (int point = 0; point < num_points; point++)
+    {
+        const double *row = &batch.rows[point * SWEEP_COLUMNS];
+        fprintf(out, "%g,%d,%.4f,%.1f,%d,%d,%.2f,%.2f\n",
+                row[0], (int)row[1], row[2], row[3], (int)row[4], (int)row[5], row[6], row[7]);
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    free(batch.rows);
+    free(batch.results);
+    free(batch.streams);
+}
+
+void run_simulation(const SimConfig *config)
+{
+    printf("\n--- Starting %g-Hour (%d Minute) Simulation ---\n",
+           config->sim_minutes / 60.0, config->sim_minutes);
+    if (config->trace == NULL)
+    {
+        printf("     Avg. Arrivals / Min (Lambda): %.2f\n", config->lambda);
+    }
+    printf("     Number of Tellers: %d\n", config->num_tellers);
+    printf("     Engine: %s\n", get_engine_name(config->engine));
+    if (config->engine == ENGINE_MINUTE)
+    {
+        printf("     Teller Tracking: %s\n",
+               (config->teller_mode == TELLERS_HEAP) ? "completion heap" : "countdown");
+    }
+    if (config->engine == ENGINE_MINUTE || config->engine == ENGINE_EVENT)
+    {
+        printf("     Queue: %s\n", get_queue_name(config->queue_type));
+    }
+    if (config->trace != NULL)
+    {
+        printf("     Arrivals: replayed from %s (%s, %.1f MB)\n", config->trace->path,
+               config->trace->binary ? "binary" : "text", config->trace->size / 1e6);
+    }
+    else if (config->engine == ENGINE_CONTINUOUS)
+    {
+        printf("     Arrivals: exponential inter-arrival times\n");
+    }
+    else
+    {
+        printf("     Arrivals: %s\n",
+               (config->arrival_mode == ARRIVALS_SORTED) ? "sorted uniform windows" : "geometric gaps");
+    }
+    if (config->profile.num_steps > 0)
+    {
+        const ArrivalProfile *profile = &config->profile;
+        double sum = 0.0, peak = 0.0;
+        for (int i = 0; i < profile->num_steps; i++)
+        {
+            sum += profile->factors[i];
+            if (profile->factors[i] > peak) peak = profile->factors[i];
+        }
+        printf("     Arrival Profile: %d steps of %d minutes, peak x%.2f, mean rate %.2f / min\n",
+               profile->num_steps, profile->step_minutes, peak, config->lambda * sum / profile->num_steps);
+    }
+    printf("     Service: ");
+    print_service(&config->service);
+    printf("     Random Seed: %llu\n", (unsigned long long)config->seed);
+    if (config->replications > 1)
+    {
+        printf("     Replications: %d\n", config->replications);
+    }
+    if (config->journey_path != NULL)
+    {
+        printf("     Journeys: recorded to %s\n", config->journey_path);
+    }
+    printf("--------------------------------------------------\n");
+
+    if (config->replications > 1)
+    {
+        run_replications(config);
+        return;
+    }
+
+    // 1. --- Initialize all simulation components ---
+
+    // Seed this run's random number stream
+    Rng rng;
+    rng_seed(&rng, config->seed);
+
+    SimResult result = {0, 0, create_storage(config->stats_type), NULL};
+    if (config->journey_path != NULL)
+    {
+        FILE *file = fopen(config->journey_path, "wb");
+        if (file == NULL)
+        {
+            perror("Failed to open journey file");
+            exit(EXIT_FAILURE);
+        }
+        // The continuous-time engine records seconds, every other engine minutes
+        result.journey = create_journey_writer(file, (config->engine == ENGINE_CONTINUOUS) ? 60 : 1,
+                                               config->seed);
+    }
+
+    // 2. --- Run the selected engine ---
+    simulate_day(config, &rng, &result);
+
+    printf("... Simulation complete.\n");
+    if (result.journey != NULL)
+    {
+        long long records = close_journey_writer(result.journey);
+        printf("... %lld customer journeys written to %s.\n", records, config->journey_path);
+    }
+    printf("\n");
+
+    // 3. --- Post-Simulation Analysis & Report ---
+    print_report(config, &result);
+
+    // 4. --- Clean up all allocated memory ---
+    free_storage(result.storage);
+}
+
+/*
+ * ============================================================================
+ * 9. BENCHMARKS AND VALIDATION
+ * ============================================================================
+ */
+
+/**
+ * @brief Gets a monotonic wall-clock time in seconds, for timing benchmarks.
+ */
+double get_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Prints one benchmark result as millions of operations per second.
+ */
+void print_bench_line(const char *label, long long n, double seconds)
+{
+    printf("%-40s %10.1f M/s  (%lld in %.3f s)\n", label, n / seconds / 1e6, n, seconds);
+}
+
+/**
+ * @brief Chi-square goodness of fit of a histogram of n Poisson(lambda)
+ * draws (counts[k - lo] for k in lo..hi) against the exact pmf, merging
+ * bins until each expects at least 5 draws; the leftover tails form the
+ * last bin. chi2_out and df_out may be NULL.
+ * @return The statistic normalized to z = (chi2 - df) / sqrt(2 df).
+ */
+double get_poisson_fit(const long long *counts, int lo, int hi, long long n, double lambda,
+                       double *chi2_out, int *df_out)
+{
+    double chi2 = 0.0, bin_expected = 0.0, bin_observed = 0.0, seen_expected = 0.0;
+    long long seen_observed = 0;
+    int df = -1;
+    for (int k = lo; k <= hi; k++)
+    {
+        double pmf = exp(-lambda + k * log(lambda) - get_log_factorial(k));
+        bin_expected += pmf * n;
+        bin_observed += counts[k - lo];
+        if (bin_expected >= 5.0)
+        {
+            chi2 += (bin_observed - bin_expected) * (bin_observed - bin_expected) / bin_expected;
+            seen_expected += bin_expected;
+            seen_observed += (long long)bin_observed;
+            bin_expected = bin_observed = 0.0;
+            df++;
+        }
+    }
+    double tail_expected = n - seen_expected;
+    double tail_observed = (double)(n - seen_observed);
+    if (tail_expected >= 5.0)
+    {
+        chi2 += (tail_observed - tail_expected) * (tail_observed - tail_expected) / tail_expected;
+        df++;
+    }
+
+    if (chi2_out != NULL) *chi2_out = chi2;
+    if (df_out != NULL) *df_out = df;
+    return (df > 0) ? (chi2 - df) / sqrt(2.0 * df) : 0.0;
+}
+
+/**
+ * @brief Compares the draw rate of the per-simulation xoshiro256** stream
+ * against the C library rand() it replaced.
+ */
+void bench_rng(long long n)
+{
+    uint64_t sink = 0;
+    int range = MAX_SERVICE_TIME - MIN_SERVICE_TIME + 1;
+    ServiceDistribution uniform_service = {0};
+    double t0;
+
+    printf("--- Random number generator throughput ---\n");
+
+    srand(1);
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++) sink += (uint64_t)rand();
+    print_bench_line("rand()", n, get_seconds() - t0);
+
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++) sink += (uint64_t)(rand() % range + MIN_SERVICE_TIME);
+    print_bench_line("rand() % range (service time)", n, get_seconds() - t0);
+
+    t0 = get_seconds();
+    double sum = 0.0;
+    for (long long i = 0; i < n; i++) sum += (double)rand() / RAND_MAX;
+    print_bench_line("rand() / RAND_MAX", n, get_seconds() - t0);
+
+    Rng rng;
+    rng_seed(&rng, 1);
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++) sink += rng_next(&rng);
+    print_bench_line("rng_next (64 bits)", n, get_seconds() - t0);
+
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++) sink += get_service_time(&rng, &uniform_service);
+    print_bench_line("get_service_time (unbiased)", n, get_seconds() - t0);
+
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++) sum += rng_uniform(&rng);
+    print_bench_line("rng_uniform (53 bits)", n, get_seconds() - t0);
+
+    long long jumps = n / 1000 + 1;
+    t0 = get_seconds();
+    for (long long i = 0; i < jumps; i++) rng_jump(&rng);
+    print_bench_line("rng_jump", jumps, get_seconds() - t0);
+
+    printf("(checksum %llu %g)\n", (unsigned long long)sink, sum);
+}
+
+/**
+ * @brief Times get_poisson_random across a range of lambda values (and
+ * Knuth's algorithm where it still terminates), and checks each sample
+ * against the Poisson distribution: mean, variance and a chi-square
+ * goodness-of-fit statistic over bins with at least 5 expected draws.
+ */
+void bench_poisson(long long n)
+{
+    static const double lambdas[] = {0.05, 0.5, 2.0, 9.99, 10.0, 30.0, 200.0, 745.0, 5000.0, 100000.0};
+    int num_lambdas = sizeof(lambdas) / sizeof(lambdas[0]);
+    long long per_lambda = n / num_lambdas + 1;
+    long long sink = 0;
+    Rng rng;
+    rng_seed(&rng, 1);
+
+    printf("--- Poisson sampler throughput and fit (%lld draws per lambda) ---\n", per_lambda);
+    printf("%10s %10s %10s %12s %12s %10s %6s %8s %10s %8s\n",
+           "lambda", "M/s", "knuth M/s", "mean", "variance", "chi2", "df", "z", "table M/s", "table z");
+
+    for (int l = 0; l < num_lambdas; l++)
+    {
+        double lambda = lambdas[l];
+
+        // Histogram of draws, centred on lambda and wide enough for the tails
+        int lo = (int)fmax(0.0, floor(lambda - 12.0 * sqrt(lambda) - 10.0));
+        int hi = (int)ceil(lambda + 12.0 * sqrt(lambda) + 10.0);
+        long long *counts = (long long *)calloc(hi - lo + 1, sizeof(long long));
+        if (counts == NULL)
+        {
+            perror("Failed to allocate memory for Poisson histogram");
+            exit(EXIT_FAILURE);
+        }
+
+        double sum = 0.0, sum_sq = 0.0;
+        double t0 = get_seconds();
+        for (long long i = 0; i < per_lambda; i++)
+        {
+            int k = get_poisson_random(&rng, lambda);
+            sum += k;
+            sum_sq += (double)k * k;
+            if (k >= lo && k <= hi) counts[k - lo]++;
+        }
+        double seconds = get_seconds() - t0;
+
+        double knuth_rate = 0.0;
+        if (lambda <= 700.0)
+        {
+            long long knuth_n = per_lambda / 10 + 1;
+            t0 = get_seconds();
+            for (long long i = 0; i < knuth_n; i++) sink += get_poisson_knuth(&rng, lambda);
+            knuth_rate = knuth_n / (get_seconds() - t0) / 1e6;
+        }
+
+        // The guided inversion table, timed without its one-off build
+        const PoissonTable *table = get_poisson_table(lambda, 0);
+        double table_rate = 0.0, table_z = 0.0;
+        if (table != NULL)
+        {
+            long long *table_counts = (long long *)calloc(hi - lo + 1, sizeof(long long));
+            if (table_counts == NULL)
+            {
+                perror("Failed to allocate memory for Poisson histogram");
+                exit(EXIT_FAILURE);
+            }
+            t0 = get_seconds();
+            for (long long i = 0; i < per_lambda; i++)
+            {
+                int k = draw_from_table(&rng, table);
+                if (k >= lo && k <= hi) table_counts[k - lo]++;
+            }
+            table_rate = per_lambda / (get_seconds() - t0) / 1e6;
+            table_z = get_poisson_fit(table_counts, lo, hi, per_lambda, lambda, NULL, NULL);
+            free(table_counts);
+        }
+
+        double chi2;
+        int df;
+        double z = get_poisson_fit(counts, lo, hi, per_lambda, lambda, &chi2, &df);
+        double mean = sum / per_lambda;
+        double variance = sum_sq / per_lambda - mean * mean;
+        printf("%10g %10.1f ", lambda, per_lambda / seconds / 1e6);
+        if (knuth_rate > 0.0) printf("%10.1f ", knuth_rate);
+        else printf("%10s ", "-");
+        printf("%12.4f %12.4f %10.1f %6d %8.2f ", mean, variance, chi2, df, z);
+        if (table_rate > 0.0) printf("%10.1f %8.2f\n", table_rate, table_z);
+        else printf("%10s %8s\n", "-", "-");
+        free(counts);
+    }
+    printf("(|z| well above 3 would indicate a sampler that does not match the Poisson pmf)\n");
+    printf("(checksum %lld)\n", sink);
+}
+
+/**
+ * @brief Times one queue backend under deep buildup: every round is one
+ * minute in which `batch` customers arrive and half as many are served, so
+ * the queue keeps growing until it is drained at the end.
+ * @param batched 1 to move each minute's customers with one enqueue_n and
+ * one dequeue_n call instead of one call per customer.
+ * @return A checksum of the dequeued minutes.
+ */
+long long bench_queue_backend(QueueType type, long long n, int batch, int batched)
+{
+    CustomerPool *pool = create_pool();
+    Queue *q = create_queue(type, pool);
+    long long sink = 0;
+    long long rounds = n / (2 * batch) + 1;
+    int taken[64];
+
+    double t0 = get_seconds();
+    for (long long r = 0; r < rounds; r++)
+    {
+        int minute = (int)(r & 0x3FFFFFFF);
+        if (batched)
+        {
+            enqueue_n(q, minute, batch);
+            int num_taken = dequeue_n(q, batch / 2, taken);
+            for (int i = 0; i < num_taken; i++)
+            {
+                sink += taken[i];
+            }
+            continue;
+        }
+        for (int i = 0; i < batch; i++)
+        {
+            enqueue(q, minute);
+        }
+        for (int i = 0; i < batch / 2; i++)
+        {
+            sink += dequeue(q);
+        }
+    }
+    long long peak_customers = q->customer_count;
+    long long peak_bytes = get_queue_bytes(q);
+    while (!is_empty(q))
+    {
+        sink += dequeue(q);
+    }
+    double seconds = get_seconds() - t0;
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s%s", get_queue_name(type), batched ? " (enqueue_n/dequeue_n)" : "");
+    print_bench_line(label, rounds * batch * 2, seconds);
+    printf("%40s %lld customers at peak in %.2f MB\n", "", peak_customers, peak_bytes / 1e6);
+
+    free_queue(q);
+    free_pool(pool);
+    return sink;
+}
+
+/**
+ * @brief Compares the queue backends, first on raw enqueue/dequeue traffic
+ * with a deep queue (light and saturated arrival batches), then on a whole
+ * overloaded simulation (lambda well above num_tellers / mean service time).
+ */
+void bench_queue(long long n)
+{
+    static const int batches[] = {3, 50};
+    long long sink = 0;
+    for (int b = 0; b < 2; b++)
+    {
+        printf("--- Queue backends, %d arrivals per minute (enqueue + dequeue operations) ---\n",
+               batches[b]);
+        for (int type = QUEUE_LIST; type <= QUEUE_RLE; type++)
+        {
+            sink += bench_queue_backend((QueueType)type, n, batches[b], 0);
+            sink += bench_queue_backend((QueueType)type, n, batches[b], 1);
+        }
+    }
+    printf("(checksum %lld)\n", sink);
+
+    // Capacity is 4 tellers / 2.5 minutes = 1.6 customers per minute
+    SimConfig config = {.lambda = 5.0,
+                        .num_tellers = 4,
+                        .sim_minutes = (int)(n / 100 > 10000 ? n / 100 : 10000),
+                        .engine = ENGINE_EVENT,
+                        .queue_type = QUEUE_LIST,
+                        .stats_type = STATS_HISTOGRAM,
+                        .teller_mode = TELLERS_COUNTDOWN,
+                        .arrival_mode = ARRIVALS_GAPS,
+                        .seed = 1,
+                        .replications = 1,
+                        .num_threads = 1};
+    printf("--- Overloaded event-driven run: lambda %.1f, %d tellers, %d minutes ---\n",
+           config.lambda, config.num_tellers, config.sim_minutes);
+    for (int type = QUEUE_LIST; type <= QUEUE_RLE; type++)
+    {
+        config.queue_type = (QueueType)type;
+        Rng rng;
+        rng_seed(&rng, config.seed);
+        SimResult result = {0, 0, create_storage(config.stats_type), NULL};
+
+        double t0 = get_seconds();
+        simulate_day(&config, &rng, &result);
+        double seconds = get_seconds() - t0;
+
+        print_bench_line(get_queue_name(config.queue_type), result.total_arrivals, seconds);
+        printf("%40s %lld customers left in queue\n", "", result.customers_left);
+        free_storage(result.storage);
+    }
+}
+
+/**
+ * @brief Compares the two statistics backends on n synthetic wait times
+ * drawn from a geometric-like distribution with a long tail.
+ */
+void bench_stats(long long n)
+{
+    if (n > INT_MAX) n = INT_MAX;
+    WaitTimeStorage storage;
+    memset(&storage, 0, sizeof(storage));
+    storage.count = storage.capacity = n;
+    storage.wait_times = (int *)malloc(n * sizeof(int));
+    if (storage.wait_times == NULL)
+    {
+        perror("Failed to allocate memory for benchmark wait times");
+        exit(EXIT_FAILURE);
+    }
+
+    Rng rng;
+    rng_seed(&rng, 1);
+    for (long long i = 0; i < n; i++)
+    {
+        storage.wait_times[i] = (int)(-30.0 * log(get_open_uniform(&rng))) % SIMULATION_MINUTES;
+    }
+
+    printf("--- Wait-time statistics over %lld samples ---\n", n);
+    WaitSummary by_stream, by_hist, by_sort;
+
+    // Streaming: the fold happens as waits arrive, so time it with the summary
+    WaitTimeStorage *stream = create_storage(STATS_STREAM);
+    double t0 = get_seconds();
+    for (long long i = 0; i < n; i++)
+    {
+        add_wait_time(stream, storage.wait_times[i]);
+    }
+    summarize_wait_times(stream, STATS_STREAM, &by_stream);
+    print_bench_line("streaming fold + summary", n, get_seconds() - t0);
+    free_storage(stream);
+
+    // Histogram first: it leaves the data unsorted for the qsort run
+    t0 = get_seconds();
+    summarize_wait_times(&storage, STATS_HISTOGRAM, &by_hist);
+    print_bench_line("histogram (no sort)", n, get_seconds() - t0);
+
+    t0 = get_seconds();
+    summarize_wait_times(&storage, STATS_SORT, &by_sort);
+    print_bench_line("qsort + scans", n, get_seconds() - t0);
+
+    printf("%-10s %10s %10s %6s %10s %6s %6s\n", "", "mean", "median", "mode", "std dev", "p95", "max");
+    printf("%-10s %10.4f %10.1f %6d %10.4f %6d %6d\n", "streaming",
+           by_stream.mean, by_stream.median, by_stream.mode, by_stream.std_dev, by_stream.p95, by_stream.max);
+    printf("%-10s %10.4f %10.1f %6d %10.4f %6d %6d\n", "histogram",
+           by_hist.mean, by_hist.median, by_hist.mode, by_hist.std_dev, by_hist.p95, by_hist.max);
+    printf("%-10s %10.4f %10.1f %6d %10.4f %6d %6d\n", "qsort",
+           by_sort.mean, by_sort.median, by_sort.mode, by_sort.std_dev, by_sort.p95, by_sort.max);
+
+    free(storage.wait_times);
+}
+
+/**
+ * @brief The original step-1 loop over interleaved Teller structs, kept as
+ * the baseline for bench_tellers.
+ */
+void tick_tellers_interleaved(Teller *tellers, int num_tellers, IdleTellers *idle)
+{
+    for (int t = 0; t < num_tellers; t++)
+    {
+        if (tellers[t].is_busy)
+        {
+            tellers[t].remaining_service_time--;
+            if (tellers[t].remaining_service_time == 0)
+            {
+                tellers[t].is_busy = 0;
+                push_idle_teller(idle, t);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Times `minutes` countdown steps of a fully loaded bank of tellers:
+ * each minute every teller is ticked and every freed teller is handed a new
+ * service time from a fixed table, as step 3 would. Both layouts see the
+ * same service times, so their idle-order checksums must match.
+ * @param interleaved 1 for the array of Teller structs, 0 for TellerClock.
+ * @return A checksum of the order in which tellers became idle.
+ */
+unsigned long long bench_teller_layout(int interleaved, int num_tellers, int minutes,
+                                       const int *services, double *seconds)
+{
+    Teller *tellers = NULL;
+    TellerClock *remaining = NULL;
+    if (interleaved)
+    {
+        tellers = (Teller *)calloc(num_tellers, sizeof(Teller));
+        if (tellers == NULL)
+        {
+            perror("Failed to allocate memory for benchmark tellers");
+            exit(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        remaining = create_teller_clocks(num_tellers);
+    }
+    IdleTellers idle;
+    init_idle_tellers(&idle, num_tellers);
+
+    unsigned long long sink = 0;
+    unsigned next_service = 0;
+    double t0 = get_seconds();
+    for (int minute = 0; minute < minutes; minute++)
+    {
+        if (interleaved)
+        {
+            tick_tellers_interleaved(tellers, num_tellers, &idle);
+        }
+        else
+        {
+            tick_tellers(remaining, num_tellers, &idle);
+        }
+        while (idle.count > 0)
+        {
+            int t = pop_idle_teller(&idle);
+            int service = services[next_service++ & 1023];
+            sink = sink * 31 + (unsigned long long)t;
+            if (interleaved)
+            {
+                tellers[t].is_busy = 1;
+                tellers[t].remaining_service_time = service;
+            }
+            else
+            {
+                remaining[t] = (TellerClock)service;
+            }
+        }
+    }
+    *seconds = get_seconds() - t0;
+
+    free_idle_tellers(&idle);
+    free(tellers);
+    free(remaining);
+    return sink;
+}
+
+/**
+ * @brief Compares the per-minute teller countdown over interleaved Teller
+ * structs with the TellerClock countdown, at 1k, 100k and 1M tellers and
+ * about n teller-minutes per case.
+ */
+void bench_tellers(long long n)
+{
+    static const int sizes[] = {1000, 100000, 1000000};
+    int services[1024];
+    ServiceDistribution uniform_service = {0};
+    Rng rng;
+    rng_seed(&rng, 1);
+    for (int i = 0; i < 1024; i++)
+    {
+        services[i] = get_service_time(&rng, &uniform_service);
+    }
+
+    printf("--- Teller countdown, fully loaded (teller-minutes) ---\n");
+    for (int s = 0; s < 3; s++)
+    {
+        int num_tellers = sizes[s];
+        long long minutes = n / num_tellers;
+        if (minutes < 1) minutes = 1;
+        if (minutes > INT_MAX) minutes = INT_MAX;
+        long long work = minutes * num_tellers;
+        char label[64];
+        double aos_seconds, soa_seconds;
+
+        unsigned long long aos = bench_teller_layout(1, num_tellers, (int)minutes, services, &aos_seconds);
+        snprintf(label, sizeof(label), "%d tellers, Teller structs", num_tellers);
+        print_bench_line(label, work, aos_seconds);
+
+        unsigned long long soa = bench_teller_layout(0, num_tellers, (int)minutes, services, &soa_seconds);
+        snprintf(label, sizeof(label), "%d tellers, TellerClock array", num_tellers);
+        print_bench_line(label, work, soa_seconds);
+
+        printf("%40s %.2fx speedup, idle order %s\n", "", aos_seconds / soa_seconds,
+               (aos == soa) ? "identical" : "DIFFERS");
+    }
+}
+
+/**
+ * @brief Compares the two arrival generators over about n arrivals per
+ * lambda: geometric gaps with table-drawn batch sizes against whole
+ * windows of sorted uniform minutes. Both must average lambda arrivals
+ * per minute.
+ */
+void bench_arrivals(long long n)
+{
+    static const double lambdas[] = {0.05, 2.0, 50.0, 1000.0};
+    static const ArrivalMode modes[] = {ARRIVALS_GAPS, ARRIVALS_SORTED};
+    static const char *names[] = {"geometric gaps", "sorted windows"};
+    // An hourly day with a lunch peak three times the morning rate; the
+    // multipliers average 1, so profiled runs keep the same arrival count
+    static double lunch_peak[] = {0.6, 0.6, 0.8, 1.8, 1.8, 0.8, 0.8, 0.8};
+
+    printf("--- Arrival generation (arrivals) ---\n");
+    for (int l = 0; l < 4; l++)
+    {
+        double minutes = n / lambdas[l];
+        SimConfig config = {.lambda = lambdas[l],
+                            .num_tellers = 1,
+                            .sim_minutes = (minutes < INT_MAX) ? (int)minutes : INT_MAX,
+                            .engine = ENGINE_MINUTE,
+                            .queue_type = QUEUE_LIST,
+                            .stats_type = STATS_HISTOGRAM,
+                            .teller_mode = TELLERS_COUNTDOWN,
+                            .arrival_mode = ARRIVALS_GAPS,
+                            .seed = 1,
+                            .replications = 1,
+                            .num_threads = 1};
+        for (int m = 0; m < 4; m++)
+        {
+            config.arrival_mode = modes[m % 2];
+            if (m >= 2)
+            {
+                config.profile.num_steps = 8;
+                config.profile.step_minutes = ARRIVAL_PROFILE_STEP;
+                config.profile.factors = lunch_peak;
+            }
+            Rng rng;
+            rng_seed(&rng, config.seed);
+
+            double t0 = get_seconds();
+            ArrivalSource arrivals;
+            open_arrivals(&arrivals, &rng, &config);
+            long long total = 0;
+            while (arrivals.minute < config.sim_minutes)
+            {
+                total += arrivals.count;
+                advance_arrivals(&arrivals);
+            }
+            close_arrivals(&arrivals);
+            double seconds = get_seconds() - t0;
+
+            char label[64];
+            snprintf(label, sizeof(label), "lambda %g, %s%s", lambdas[l], names[m % 2],
+                     (m >= 2) ? ", profile" : "");
+            print_bench_line(label, total, seconds);
+            printf("%40s %.5f arrivals per minute\n", "", (double)total / config.sim_minutes);
+        }
+    }
+}
+
+/**
+ * @brief Prints the mean and standard deviation of a timed sample next to
+ * the values the distribution should have.
+ */
+void print_sample_moments(double sum, double sum_sq, long long n, double mean, double sd)
+{
+    double sample_mean = sum / n;
+    double sample_sd = sqrt(sum_sq / n - sample_mean * sample_mean);
+    printf("%40s mean %.4f (expected %.4f), sd %.4f (expected %.4f)\n", "",
+           sample_mean, mean, sample_sd, sd);
+}
+
+/**
+ * @brief Compares service-time samplers in samples per second: the
+ * original rand() % range and unbiased uniform draws, the ziggurat against
+ * -log(U) and Box-Muller, and the alias table against a linear search of
+ * the cumulative weights, checking each sample's mean and deviation.
+ */
+void bench_service(long long n)
+{
+    static const double minutes[] = {1, 2, 3, 4, 5, 6, 8, 10, 12, 15, 20, 25, 30, 40, 50, 60};
+    static const double weights[] = {5, 20, 25, 15, 10, 7, 5, 4, 3, 2, 1.5, 1, 0.7, 0.4, 0.25, 0.15};
+    const int num_values = sizeof(minutes) / sizeof(minutes[0]);
+    const double two_pi = 6.283185307179586;
+    int range = MAX_SERVICE_TIME - MIN_SERVICE_TIME + 1;
+    ServiceDistribution service = {0};
+    const Ziggurat *zig = get_ziggurat();
+    double sum, sum_sq, t0;
+    long long sink = 0;
+    Rng rng;
+    rng_seed(&rng, 1);
+
+    printf("--- Service-time samplers (samples) ---\n");
+
+    srand(1);
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++) sink += rand() % range + MIN_SERVICE_TIME;
+    print_bench_line("uniform, rand() % range", n, get_seconds() - t0);
+
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++) sink += get_service_time(&rng, &service);
+    print_bench_line("uniform, get_service_time", n, get_seconds() - t0);
+
+    sum = sum_sq = 0.0;
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++)
+    {
+        double x = -log(get_open_uniform(&rng));
+        sum += x;
+        sum_sq += x * x;
+    }
+    print_bench_line("exponential, -log(U)", n, get_seconds() - t0);
+    print_sample_moments(sum, sum_sq, n, 1.0, 1.0);
+
+    sum = sum_sq = 0.0;
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++)
+    {
+        double x = get_exponential_ziggurat(&rng, zig);
+        sum += x;
+        sum_sq += x * x;
+    }
+    print_bench_line("exponential, ziggurat", n, get_seconds() - t0);
+    print_sample_moments(sum, sum_sq, n, 1.0, 1.0);
+
+    sum = sum_sq = 0.0;
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++)
+    {
+        double x = sqrt(-2.0 * log(get_open_uniform(&rng))) * cos(two_pi * rng_uniform(&rng));
+        sum += x;
+        sum_sq += x * x;
+    }
+    print_bench_line("normal, Box-Muller", n, get_seconds() - t0);
+    print_sample_moments(sum, sum_sq, n, 0.0, 1.0);
+
+    sum = sum_sq = 0.0;
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++)
+    {
+        double x = get_normal_ziggurat(&rng, zig);
+        sum += x;
+        sum_sq += x * x;
+    }
+    print_bench_line("normal, ziggurat", n, get_seconds() - t0);
+    print_sample_moments(sum, sum_sq, n, 0.0, 1.0);
+
+    parse_service("lognormal", &service);
+    sum = sum_sq = 0.0;
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++)
+    {
+        double x = get_service_minutes(&rng, &service);
+        sum += x;
+        sum_sq += x * x;
+    }
+    print_bench_line("lognormal, ziggurat", n, get_seconds() - t0);
+    print_sample_moments(sum, sum_sq, n, service.mean, 1.0);
+
+    double total = 0.0, mean = 0.0, second = 0.0;
+    double cumulative[16];
+    for (int i = 0; i < num_values; i++)
+    {
+        total += weights[i];
+        cumulative[i] = total;
+    }
+    for (int i = 0; i < num_values; i++)
+    {
+        mean += minutes[i] * weights[i] / total;
+        second += minutes[i] * minutes[i] * weights[i] / total;
+    }
+    double sd = sqrt(second - mean * mean);
+
+    sum = sum_sq = 0.0;
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++)
+    {
+        double u = rng_uniform(&rng) * total;
+        int k = 0;
+        while (k < num_values - 1 && u >= cumulative[k]) k++;
+        double x = minutes[k];
+        sum += x;
+        sum_sq += x * x;
+    }
+    print_bench_line("empirical (16), linear search", n, get_seconds() - t0);
+    print_sample_moments(sum, sum_sq, n, mean, sd);
+
+    AliasTable *alias = create_alias_table(weights, num_values);
+    sum = sum_sq = 0.0;
+    t0 = get_seconds();
+    for (long long i = 0; i < n; i++)
+    {
+        double x = minutes[draw_alias(&rng, alias)];
+        sum += x;
+        sum_sq += x * x;
+    }
+    print_bench_line("empirical (16), alias table", n, get_seconds() - t0);
+    print_sample_moments(sum, sum_sq, n, mean, sd);
+    free_alias_table(alias);
+
+    printf("(checksum %lld)\n", sink);
+}
+
+/**
+ * @brief Times trace replay over about n in-memory records: the SWAR text
+ * reader against strtod on the same CSV lines, and the binary format.
+ * Timestamps look like epoch seconds with milliseconds, and all three
+ * readers must produce the same sum.
+ */
+void bench_trace(long long n)
+{
+    const int line_length = 17; // "1700000000.123,7\n"
+    char *text = (char *)malloc((size_t)n * line_length + 1);
+    char *binary = (char *)malloc(8 + (size_t)n * 8);
+    if (text == NULL || binary == NULL)
+    {
+        perror("Failed to allocate memory for benchmark trace");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(binary, TRACE_MAGIC, 8);
+    Rng rng;
+    rng_seed(&rng, 1);
+    long long milliseconds = 1700000000000LL;
+    for (long long i = 0; i < n; i++)
+    {
+        char line[64];
+        milliseconds += rng_bounded(&rng, 80000);
+        snprintf(line, sizeof(line), "%lld.%03lld,7\n", milliseconds / 1000, milliseconds % 1000);
+        memcpy(text + i * line_length, line, line_length);
+        double seconds = milliseconds / 1000.0;
+        uint64_t bits;
+        memcpy(&bits, &seconds, 8);
+        if (!HOST_LITTLE_ENDIAN) bits = __builtin_bswap64(bits);
+        memcpy(binary + 8 + i * 8, &bits, 8);
+    }
+    ArrivalTrace text_trace = {"(memory)", text, (size_t)n * line_length, 0, 0.0, 0};
+    ArrivalTrace binary_trace = {"(memory)", binary, 8 + (size_t)n * 8, 1, 0.0, 0};
+
+    printf("--- Trace replay (records) ---\n");
+    TraceCursor cursor;
+    double seconds, swar_sum = 0.0, strtod_sum = 0.0, binary_sum = 0.0;
+
+    double t0 = get_seconds();
+    open_trace_cursor(&cursor, &text_trace);
+    while (read_trace_seconds(&cursor, &seconds)) swar_sum += seconds;
+    double elapsed = get_seconds() - t0;
+    print_bench_line("text, SWAR digits", n, elapsed);
+    printf("%40s %.0f MB/s\n", "", text_trace.size / elapsed / 1e6);
+
+    // strtod needs a terminated string; the final newline stops it
+    text[text_trace.size] = '\0';
+    t0 = get_seconds();
+    char *p = text;
+    while (*p != '\0')
+    {
+        strtod_sum += strtod(p, &p);
+        p = strchr(p, '\n') + 1;
+    }
+    elapsed = get_seconds() - t0;
+    print_bench_line("text, strtod", n, elapsed);
+    printf("%40s %.0f MB/s\n", "", text_trace.size / elapsed / 1e6);
+
+    t0 = get_seconds();
+    open_trace_cursor(&cursor, &binary_trace);
+    while (read_trace_seconds(&cursor, &seconds)) binary_sum += seconds;
+    elapsed = get_seconds() - t0;
+    print_bench_line("binary doubles", n, elapsed);
+    printf("%40s %.0f MB/s\n", "", binary_trace.size / elapsed / 1e6);
+
+    printf("Readers %s (sums %.3f, %.3f, %.3f)\n",
+           (swar_sum == strtod_sum && swar_sum == binary_sum) ? "agree" : "DISAGREE",
+           swar_sum, strtod_sum, binary_sum);
+    free(text);
+    free(binary);
+}
+
+/**
+ * @brief Times each engine over about n / 10 customers without --journey,
+ * recording to /dev/null (the cost of recording alone) and recording to a
+ * temporary file (plus the kernel's cost of writing it), and checks that
+ * one record is written per served customer. Service is uniform 2-3
+ * minutes and 52 tellers take lambda 20, so almost every customer is
+ * served. The three kinds of run alternate and each keeps its best of
+ * JOURNEY_BENCH_ROUNDS, so a stray scheduler hiccup does not decide the
+ * overhead.
+ */
+void bench_journey(long long n)
+{
+    static const EngineType engines[] = {ENGINE_MINUTE, ENGINE_EVENT, ENGINE_LINDLEY, ENGINE_CONTINUOUS};
+    long long minutes = n / 10 / 20;
+    SimConfig config = {.lambda = 20.0,
+                        .num_tellers = 52,
+                        .sim_minutes = (int)((minutes < 1000) ? 1000 : (minutes < INT_MAX) ? minutes : INT_MAX),
+                        .engine = ENGINE_MINUTE,
+                        .queue_type = QUEUE_LIST,
+                        .stats_type = STATS_STREAM,
+                        .teller_mode = TELLERS_COUNTDOWN,
+                        .arrival_mode = ARRIVALS_GAPS,
+                        .seed = 1,
+                        .replications = 1,
+                        .num_threads = 1};
+
+    printf("--- Journey recording: lambda %.1f, %d tellers, %d minutes (customers) ---\n",
+           config.lambda, config.num_tellers, config.sim_minutes);
+    for (int e = 0; e < 4; e++)
+    {
+        config.engine = engines[e];
+        double seconds[3] = {INFINITY, INFINITY, INFINITY};
+        long long served = 0, records = 0;
+        for (int run = 0; run < 3 * JOURNEY_BENCH_ROUNDS; run++)
+        {
+            int record = run % 3; // 0 = off, 1 = to /dev/null, 2 = to a file
+            Rng rng;
+            rng_seed(&rng, config.seed);
+            SimResult result = {0, 0, create_storage(config.stats_type), NULL};
+            if (record)
+            {
+                FILE *file = (record == 1) ? fopen("/dev/null", "wb") : tmpfile();
+                if (file == NULL)
+                {
+                    perror("Failed to create temporary journey file");
+                    exit(EXIT_FAILURE);
+                }
+                result.journey = create_journey_writer(file, (config.engine == ENGINE_CONTINUOUS) ? 60 : 1,
+                                                       config.seed);
+            }
+
+            double t0 = get_seconds();
+            simulate_day(&config, &rng, &result);
+            if (record)
+            {
+                records = close_journey_writer(result.journey);
+            }
+            double elapsed = get_seconds() - t0;
+            if (elapsed < seconds[record]) seconds[record] = elapsed;
+
+            served = result.storage->count;
+            free_storage(result.storage);
+        }
+
+        char label[64];
+        snprintf(label, sizeof(label), "%s", get_engine_name(config.engine));
+        print_bench_line(label, served, seconds[0]);
+        snprintf(label, sizeof(label), "%s + journey, /dev/null", get_engine_name(config.engine));
+        print_bench_line(label, served, seconds[1]);
+        snprintf(label, sizeof(label), "%s + journey, file", get_engine_name(config.engine));
+        print_bench_line(label, served, seconds[2]);
+        printf("%40s %+.1f%% recording, %+.1f%% with the write; %lld records (%s), %.0f MB\n", "",
+               100.0 * (seconds[1] / seconds[0] - 1.0), 100.0 * (seconds[2] / seconds[0] - 1.0), records,
+               (records == served) ? "one per customer" : "MISMATCH",
+               (sizeof(JourneyHeader) + records * sizeof(JourneyRecord)) / 1e6);
+    }
+}
+
+/**
+ * @brief Runs the named benchmark.
+ * @return 1 if the benchmark exists, 0 otherwise.
+ */
+int run_benchmark(const BenchSpec *bench)
+{
+    long long n = (bench->samples > 0) ? bench->samples : DEFAULT_BENCH_SAMPLES;
+    if (strcmp(bench->name, "rng") == 0)
+    {
+        bench_rng(n);
+        return 1;
+    }
+    if (strcmp(bench->name, "poisson") == 0)
+    {
+        bench_poisson(n);
+        return 1;
+    }
+    if (strcmp(bench->name, "queue") == 0)
+    {
+        bench_queue(n);
+        return 1;
+    }
+    if (strcmp(bench->name, "stats") == 0)
+    {
+        bench_stats(n);
+        return 1;
+    }
+    if (strcmp(bench->name, "tellers") == 0)
+    {
+        bench_tellers(n);
+        return 1;
+    }
+    if (strcmp(bench->name, "arrivals") == 0)
+    {
+        bench_arrivals(n);
+        return 1;
+    }
+    if (strcmp(bench->name, "service") == 0)
+    {
+        bench_service(n);
+        return 1;
+    }
+    if (strcmp(bench->name, "trace") == 0)
+    {
+        bench_trace(n);
+        return 1;
+    }
+    if (strcmp(bench->name, "journey") == 0)
+    {
+        bench_journey(n);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Runs every engine (and both teller-tracking modes of the
+ * minute-stepped one) on the same random streams and checks that they
+ * agree exactly: same arrivals, same customers left and the same wait
+ * summary, day by day.
+ * @return 1 if all engines agree on every replication, 0 otherwise.
+ */
+int run_validation(const SimConfig *config)
+{
+    static const EngineType engines[] = {ENGINE_MINUTE, ENGINE_MINUTE, ENGINE_EVENT, ENGINE_LINDLEY};
+    static const TellerMode modes[] = {TELLERS_COUNTDOWN, TELLERS_HEAP, TELLERS_COUNTDOWN, TELLERS_COUNTDOWN};
+    static const char *labels[] = {"minute-stepped (countdown)", "minute-stepped (heap)",
+                                   "event-driven", "Kiefer-Wolfowitz"};
+    int num_engines = 4;
+
+    char arrivals[64];
+    if (config->trace != NULL)
+    {
+        snprintf(arrivals, sizeof(arrivals), "trace");
+    }
+    else
+    {
+        snprintf(arrivals, sizeof(arrivals), "lambda %.2f", config->lambda);
+    }
+    printf("\n--- Validating engines: %s, %d tellers, %d minutes, seed %llu, %d day(s) ---\n",
+           arrivals, config->num_tellers, config->sim_minutes,
+           (unsigned long long)config->seed, config->replications);
+
+    Rng *streams = create_streams(config->seed, config->replications);
+    int mismatches = 0;
+    for (int r = 0; r < config->replications; r++)
+    {
+        SimResult reference = {0, 0, NULL, NULL};
+        WaitSummary expected = {0};
+        for (int e = 0; e < num_engines; e++)
+        {
+            SimConfig engine_config = *config;
+            engine_config.engine = engines[e];
+            engine_config.teller_mode = modes[e];
+
+            Rng rng = streams[r];
+            SimResult result = {0, 0, create_storage(config->stats_type), NULL};
+            double t0 = get_seconds();
+            simulate_day(&engine_config, &rng, &result);
+            double seconds = get_seconds() - t0;
+
+            WaitSummary summary;
+            summarize_wait_times(result.storage, config->stats_type, &summary);
+            int agrees = 1;
+            if (e == 0)
+            {
+                reference = result;
+                expected = summary;
+            }
+            else
+            {
+                agrees = result.total_arrivals == reference.total_arrivals &&
+                         result.customers_left == reference.customers_left &&
+                         summary.count == expected.count && summary.mean == expected.mean &&
+                         summary.median == expected.median && summary.mode == expected.mode &&
+                         summary.std_dev == expected.std_dev && summary.p95 == expected.p95 &&
+                         summary.max == expected.max;
+                free_storage(result.storage);
+            }
+            mismatches += !agrees;
+
+            if (r == 0 || !agrees)
+            {
+                printf("day %-4d %-28s arrived %9lld  left %7lld  mean wait %9.4f  p95 %6d  %8.4f s  %s\n",
+                       r, labels[e], result.total_arrivals, result.customers_left, summary.mean,
+                       summary.p95, seconds, agrees ? "ok" : "MISMATCH");
+            }
+        }
+        free_storage(reference.storage);
+    }
+    free(streams);
+
+    if (mismatches == 0)
+    {
+        printf("All engines agree on all %d day(s).\n", config->replications);
+        return 1;
+    }
+    printf("%d engine run(s) disagreed with the minute-stepped engine.\n", mismatches);
+    return 0;
+}
+
+/*
+ * ============================================================================
+ * 10. MAIN FUNCTION
+ * ============================================================================
+ */
+
+/**
+ * @brief Parses a whole decimal number from 1 to INT_MAX with nothing
+ * after it, so typos such as "5x" are rejected rather than read as 5.
+ * @return 1 if the text is valid (and *value is set), 0 otherwise.
+ */
+int parse_positive_int(const char *text, int *value)
+{
+    char *end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || parsed < 1 || parsed > INT_MAX)
+    {
+        return 0;
+    }
+    *value = (int)parsed;
+    return 1;
+}
+
+/**
+ * @brief Parses "first:last:step", "first:last" (step 1) or a single value.
+ * @param whole 1 if first, last and step must be integers (teller counts).
+ * @return 1 if the text is a valid range, 0 otherwise.
+ */
+int parse_range(const char *text, SweepRange *range, int whole)
+{
+    char *end;
+    range->first = strtod(text, &end);
+    range->last = range->first;
+    range->step = 1.0;
+    if (*end == ':')
+    {
+        range->last = strtod(end + 1, &end);
+        if (*end == ':')
+        {
+            range->step = strtod(end + 1, &end);
+        }
+    }
+    if (*end != '\0' || !(range->first > 0) || !(range->last >= range->first) || !(range->step > 0))
+    {
+        return 0;
+    }
+    if (whole)
+    {
+        // Truncating fractional counts would repeat grid points
+        return range->last <= INT_MAX && range->first == floor(range->first) &&
+               range->last == floor(range->last) && range->step == floor(range->step);
+    }
+    return 1;
+}
+
+/**
+ * @brief Parses "f1,f2,..." into the profile's multipliers of lambda, keeping
+ * its step length. Multipliers must be non-negative with at least one
+ * positive, or no arrival could ever be drawn.
+ * @return 1 if the text is a valid profile, 0 otherwise.
+ */
+int parse_profile(const char *text, ArrivalProfile *profile)
+{
+    int n = 1;
+    for (const char *c = text; *c != '\0'; c++) n += (*c == ',');
+    double *factors = (double *)malloc(n * sizeof(double));
+    if (factors == NULL)
+    {
+        perror("Failed to allocate memory for arrival profile");
+        exit(EXIT_FAILURE);
+    }
+    const char *cursor = text;
+    char *end = NULL;
+    double peak = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        factors[i] = strtod(cursor, &end);
+        if (end == cursor || !(factors[i] >= 0.0) || (*end != ',' && *end != '\0'))
+        {
+            free(factors);
+            return 0;
+        }
+        if (factors[i] > peak) peak = factors[i];
+        cursor = end + 1;
+    }
+    if (*end != '\0' || !(peak > 0.0))
+    {
+        free(factors);
+        return 0;
+    }
+    free(profile->factors);
+    profile->factors = factors;
+    profile->num_steps = n;
+    return 1;
+}
+
+/**
+ * @brief Applies one "--name=value" command-line option to the config.
+ * @return 1 if the option was recognized and valid, 0 otherwise.
+ */
+int parse_option(SimConfig *config, SweepSpec *sweep, BenchSpec *bench, const char *arg)
+{
+    if (strcmp(arg, "--engine=minute") == 0)
+    {
+        config->engine = ENGINE_MINUTE;
+        return 1;
+    }
+    if (strcmp(arg, "--engine=event") == 0)
+    {
+        config->engine = ENGINE_EVENT;
+        return 1;
+    }
+    if (strcmp(arg, "--engine=lindley") == 0)
+    {
+        config->engine = ENGINE_LINDLEY;
+        return 1;
+    }
+    if (strcmp(arg, "--engine=scan") == 0)
+    {
+        config->engine = ENGINE_SCAN;
+        return 1;
+    }
+    if (strcmp(arg, "--engine=continuous") == 0)
+    {
+        config->engine = ENGINE_CONTINUOUS;
+        return 1;
+    }
+    if (strcmp(arg, "--validate") == 0)
+    {
+        bench->validate = 1;
+        return 1;
+    }
+    if (strcmp(arg, "--queue=list") == 0)
+    {
+        config->queue_type = QUEUE_LIST;
+        return 1;
+    }
+    if (strcmp(arg, "--queue=ring") == 0)
+    {
+        config->queue_type = QUEUE_RING;
+        return 1;
+    }
+    if (strcmp(arg, "--queue=rle") == 0)
+    {
+        config->queue_type = QUEUE_RLE;
+        return 1;
+    }
+    if (strcmp(arg, "--stats=sort") == 0)
+    {
+        config->stats_type = STATS_SORT;
+        return 1;
+    }
+    if (strcmp(arg, "--stats=histogram") == 0)
+    {
+        config->stats_type = STATS_HISTOGRAM;
+        return 1;
+    }
+    if (strcmp(arg, "--stats=stream") == 0)
+    {
+        config->stats_type = STATS_STREAM;
+        return 1;
+    }
+    if (strcmp(arg, "--arrivals=gaps") == 0)
+    {
+        config->arrival_mode = ARRIVALS_GAPS;
+        return 1;
+    }
+    if (strcmp(arg, "--arrivals=sorted") == 0)
+    {
+        config->arrival_mode = ARRIVALS_SORTED;
+        return 1;
+    }
+    if (strncmp(arg, "--service=", 10) == 0)
+    {
+        free_service_distribution(&config->service);
+        return parse_service(arg + 10, &config->service);
+    }
+    if (strncmp(arg, "--service-file=", 15) == 0)
+    {
+        free_service_distribution(&config->service);
+        load_service_file(arg + 15, &config->service);
+        return 1;
+    }
+    if (strcmp(arg, "--teller-tracking=countdown") == 0)
+    {
+        config->teller_mode = TELLERS_COUNTDOWN;
+        return 1;
+    }
+    if (strcmp(arg, "--teller-tracking=heap") == 0)
+    {
+        config->teller_mode = TELLERS_HEAP;
+        return 1;
+    }
+    if (strncmp(arg, "--trace=", 8) == 0)
+    {
+        if (config->trace != NULL)
+        {
+            close_arrival_trace((ArrivalTrace *)config->trace);
+        }
+        config->trace = open_arrival_trace(arg + 8);
+        return 1;
+    }
+    if (strncmp(arg, "--journey=", 10) == 0)
+    {
+        config->journey_path = arg + 10;
+        return arg[10] != '\0';
+    }
+    if (strncmp(arg, "--profile=", 10) == 0)
+    {
+        return parse_profile(arg + 10, &config->profile);
+    }
+    if (strncmp(arg, "--profile-step=", 15) == 0)
+    {
+        return parse_positive_int(arg + 15, &config->profile.step_minutes);
+    }
+    if (strncmp(arg, "--minutes=", 10) == 0)
+    {
+        return parse_positive_int(arg + 10, &config->sim_minutes);
+    }
+    if (strncmp(arg, "--seed=", 7) == 0)
+    {
+        // strtoull would silently wrap a leading minus sign
+        char *end;
+        errno = 0;
+        config->seed = strtoull(arg + 7, &end, 10);
+        return end != arg + 7 && *end == '\0' && errno == 0 && arg[7] != '-';
+    }
+    if (strncmp(arg, "--replications=", 15) == 0)
+    {
+        return parse_positive_int(arg + 15, &config->replications);
+    }
+    if (strncmp(arg, "--threads=", 10) == 0)
+    {
+        return parse_positive_int(arg + 10, &config->num_threads);
+    }
+    if (strncmp(arg, "--lambda=", 9) == 0)
+    {
+        char *end;
+        config->lambda = strtod(arg + 9, &end);
+        return end != arg + 9 && *end == '\0' && config->lambda > 0 && isfinite(config->lambda);
+    }
+    if (strncmp(arg, "--tellers=", 10) == 0)
+    {
+        return parse_positive_int(arg + 10, &config->num_tellers);
+    }
+    if (strncmp(arg, "--sweep-lambda=", 15) == 0)
+    {
+        return parse_range(arg + 15, &sweep->lambda, 0);
+    }
+    if (strncmp(arg, "--sweep-tellers=", 16) == 0)
+    {
+        return parse_range(arg + 16, &sweep->tellers, 1);
+    }
+    if (strncmp(arg, "--bench=", 8) == 0)
+    {
+        bench->name = arg + 8;
+        return 1;
+    }
+    if (strncmp(arg, "--bench-n=", 10) == 0)
+    {
+        char *end;
+        errno = 0;
+        bench->samples = strtoll(arg + 10, &end, 10);
+        return end != arg + 10 && *end == '\0' && errno == 0 && bench->samples > 0;
+    }
+    if (strncmp(arg, "--output=", 9) == 0)
+    {
+        sweep->output_path = arg + 9;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Releases what the options loaded: service tables, the arrival
+ * profile and the mapped trace.
+ */
+void free_options(SimConfig *config)
+{
+    free_service_distribution(&config->service);
+    free(config->profile.factors);
+    config->profile.factors = NULL;
+    if (config->trace != NULL)
+    {
+        close_arrival_trace((ArrivalTrace *)config->trace);
+        config->trace = NULL;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // sim_minutes stays 0 until --minutes, so a replayed trace can default to its own span
+    SimConfig config = {.lambda = 0.0,
+                        .num_tellers = 0,
+                        .sim_minutes = 0,
+                        .engine = ENGINE_MINUTE,
+                        .queue_type = QUEUE_LIST,
+                        .stats_type = STATS_HISTOGRAM,
+                        .teller_mode = TELLERS_COUNTDOWN,
+                        .arrival_mode = ARRIVALS_GAPS,
+                        .seed = (uint64_t)time(NULL),
+                        .replications = 1,
+                        .num_threads = 0,
+                        .profile = {.step_minutes = ARRIVAL_PROFILE_STEP}};
+    SweepSpec sweep = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, NULL};
+    BenchSpec bench = {NULL, 0, 0};
+    atexit(free_poisson_tables);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!parse_option(&config, &sweep, &bench, argv[i]))
+        {
+            printf("Unknown or invalid option: %s\n", argv[i]);
+            printf("Usage: %s [--engine=minute|event|lindley|scan|continuous] [--queue=list|ring|rle]\n"
+                   "          [--stats=histogram|sort|stream]\n"
+                   "          [--arrivals=gaps|sorted] [--teller-tracking=countdown|heap]\n"
+                   "          [--service=uniform|exponential[:MEAN]|lognormal[:MEAN,SD]|empirical:V=W,...]\n"
+                   "          [--service-file=DURATIONS]\n"
+                   "          [--profile=F1,F2,...] [--profile-step=MINUTES] [--trace=ARRIVALS]\n"
+                   "          [--journey=FILE]\n"
+                   "          [--minutes=N] [--seed=S]\n"
+                   "          [--replications=N] [--threads=N] [--lambda=X] [--tellers=N]\n"
+                   "          [--sweep-lambda=FIRST:LAST:STEP] [--sweep-tellers=FIRST:LAST:STEP]\n"
+                   "          [--output=FILE.csv] [--bench=rng|poisson|queue|stats|tellers|arrivals|service|trace|journey]\n"
+                   "          [--bench-n=N]\n"
+                   "          [--validate]\n", argv[0]);
+            free_options(&config);
+            return 1;
+        }
+    }
+
+    if (config.sim_minutes == 0)
+    {
+        config.sim_minutes = SIMULATION_MINUTES;
+        if (config.trace != NULL)
+        {
+            // Replay the whole log unless --minutes says otherwise
+            long long span = config.trace->span_minutes;
+            config.sim_minutes = (span < INT_MAX) ? (int)span : INT_MAX;
+        }
+    }
+    if (config.trace != NULL)
+    {
+        if (config.engine == ENGINE_SCAN && !bench.validate)
+        {
+            printf("--engine=scan starts every chunk mid-day and cannot replay a trace.\n");
+            free_options(&config);
+            return 1;
+        }
+        if (config.profile.num_steps > 0 || sweep.lambda.step > 0.0)
+        {
+            printf("A replayed trace fixes the arrivals: --profile and --sweep-lambda do not apply.\n");
+            free_options(&config);
+            return 1;
+        }
+    }
+    if (config.journey_path != NULL &&
+        (config.engine == ENGINE_SCAN || config.replications > 1 || bench.validate ||
+         sweep.lambda.step > 0.0 || sweep.tellers.step > 0.0))
+    {
+        printf("--journey records the customers of one day: it needs a single replication,\n"
+               "no sweep or validation, and an engine other than scan.\n");
+        free_options(&config);
+        return 1;
+    }
+
+    if (bench.name != NULL)
+    {
+        if (!run_benchmark(&bench))
+        {
+            printf("Unknown benchmark: %s\n", bench.name);
+            free_options(&config);
+            return 1;
+        }
+        free_options(&config);
+        return 0;
+    }
+
+    // Sweep mode is fully non-interactive: an axis that is not swept is
+    // pinned to the value given with --lambda or --tellers.
+    if (sweep.lambda.step > 0.0 || sweep.tellers.step > 0.0)
+    {
+        if (config.engine == ENGINE_SCAN)
+        {
+            printf("--engine=scan splits one day across threads and cannot be swept.\n");
+            free_options(&config);
+            return 1;
+        }
+        if (sweep.lambda.step == 0.0)
+        {
+            sweep.lambda.first = sweep.lambda.last = config.lambda;
+        }
+        if (sweep.tellers.step == 0.0)
+        {
+            sweep.tellers.first = sweep.tellers.last = config.num_tellers;
+        }
+        if ((sweep.lambda.first <= 0 && config.trace == NULL) || sweep.tellers.first < 1)
+        {
+            printf("A sweep needs a lambda and a number of tellers for every grid point.\n");
+            free_options(&config);
+            return 1;
+        }
+        run_sweep(&config, &sweep);
+        free_options(&config);
+        return 0;
+    }
+
+    printf("--- 🏦 Welcome to the Bank Queue Simulator ---\n");
+    printf("This program will simulate %g hours (%d minutes) of the bank.\n\n",
+           config.sim_minutes / 60.0, config.sim_minutes);
+
+    // Get Lambda from user, unless the arrivals come from a trace
+    if (config.lambda <= 0 && config.trace == NULL)
+    {
+        printf("Enter the average number of customers arriving *per minute* (lambda): ");
+        if (scanf("%lf", &config.lambda) != 1 || config.lambda <= 0) {
+            printf("Invalid input. Please enter a positive number.\n");
+            free_options(&config);
+            return 1;
+        }
+    }
+
+    // Get number of tellers from user
+    if (config.num_tellers <= 0)
+    {
+        printf("Enter the number of tellers working: ");
+        if (scanf("%d", &config.num_tellers) != 1 || config.num_tellers <= 0) {
+            printf("Invalid input. Please enter a positive number of tellers.\n");
+            free_options(&config);
+            return 1;
+        }
+    }
+
+    // Validation compares its own fixed set of engines and ignores --engine
+    if (bench.validate)
+    {
+        int agree = run_validation(&config);
+        free_options(&config);
+        return agree ? 0 : 1;
+    }
+
+    if (config.engine == ENGINE_SCAN && (config.num_tellers != 1 || config.replications != 1))
+    {
+        printf("--engine=scan needs exactly one teller and one replication.\n");
+        free_options(&config);
+        return 1;
+    }
+
+    // Run the main simulation
+    run_simulation(&config);
+    free_options(&config);
+
+    return 0;
+}